@@ -0,0 +1,180 @@
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+
+
+#include <cstring>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+#include "TSPSolver.h"
+#include "ThreadPool.h"
+
+#define __BATCH_QUEUE_PER_THREAD__ 4	// instances in flight per pool thread before submit() blocks, bounds the memory of a long stream
+
+#if ATOMIC_BOOL_LOCK_FREE != 2
+#error "the batch stop flag is set by a signal handler, it needs a lock free std::atomic<bool>"
+#endif
+
+
+// result of one instance of a batch, given to the call back once its solve ends
+//
+struct TSPBatchResult {
+	long long _index;			// submission order of the instance, from 0
+	const char *_name;			// name given to submit()
+	int _vtxCount;				// cities count
+	const TSPResult *_result;	// result of the solve, its best tour is only valid during the call back
+	int _thread;				// pool thread which solved the instance
+};
+
+typedef void (*TSPBatchCallback)(const TSPBatchResult &result, void *data);
+
+
+// solver of a stream of independent instances, every instance is solved by its own single threaded solver
+// on a thread of a work stealing pool, so the throughput scales with the cores without a process per instance.
+// an instance owns a copy of its cities, its solver, distance oracle and random engines, nothing is shared between the solves
+// but the config. the call backs come from the pool threads as the solves end, in completion order, one at a time
+//
+class TSPBatch {
+public:
+	// solve every instance with the given config, its thread count is ignored, threadCount pool threads, 0 uses every hardware thread
+	//
+	TSPBatch(const TSPConfig &config, int threadCount);
+	~TSPBatch();		// finish the submitted instances
+
+	void callback(TSPBatchCallback cb, void *data) { _callback = cb; _callbackData = data; }
+	int threadCount() const { return _pool.threadCount(); }
+
+	// queue an instance, its name and cities are copied, blocks while too many instances are in flight,
+	// an instance of less than 2 cities is skipped without call back
+	//
+	void submit(const char *name, const GVertexStore &vertices);
+	void finish();		// block until every submitted instance is solved or skipped
+	// stop the running solves at the end of their generations, their call backs get the best tours so far,
+	// and skip the queued instances, only sets a flag so a signal handler may call it
+	//
+	void stop() { _stopping.store(true, std::memory_order_relaxed); }
+	bool stopped() const { return _stopping.load(std::memory_order_relaxed); }
+	long long solved() const { return _solved; }	// instances solved, the stopped ones included, read it after finish()
+
+private:
+	TSPBatch(const TSPBatch &);
+	TSPBatch &operator=(const TSPBatch &);
+
+	// instance waiting in the pool or being solved
+	//
+	struct TSPBatchJob {
+		TSPBatch *_batch;
+		long long _index;
+		char *_name;
+		GVertexStore _vertices;
+	};
+
+	static void solveTask(void *data, int thread);
+	static void solveProgress(const TSPSolver *solver, int generation, bool improved, void *data);
+	void release();
+
+	TSPConfig _config;				// config of every solve
+	GTaskPool _pool;				// threads solving the instances
+	TSPBatchCallback _callback;		// result call back
+	void *_callbackData;			// data of the call back
+	std::mutex _mutex;				// guards the counts
+	std::mutex _callbackMutex;		// serializes the call backs
+	std::condition_variable _room;	// signals an instance leaving the batch
+	int _inFlight;					// instances submitted and not yet done
+	int _maxInFlight;				// instances in flight before submit() blocks
+	long long _submitted;			// instances submitted
+	long long _solved;				// instances solved
+	std::atomic<bool> _stopping;	// set by stop(), the queued instances are skipped, lock free so a signal handler may set it
+};
+
+
+TSPBatch::TSPBatch(const TSPConfig &config, int threadCount)
+	: _config(config), _pool(threadCount ? threadCount : GThreadPool::hardwareThreads()), _callback(NULL), _callbackData(NULL),
+	_inFlight(0), _submitted(0), _solved(0), _stopping(false) {
+	// one thread per solve, the parallelism is across the instances, and no checkpoint file shared by all the solves
+	//
+	_config._threadCount = 1;
+	_config._checkpointPath = NULL;
+	_maxInFlight = __BATCH_QUEUE_PER_THREAD__ * _pool.threadCount();
+}
+
+TSPBatch::~TSPBatch() {
+	finish();
+}
+
+void TSPBatch::submit(const char *name, const GVertexStore &vertices) {
+	TSPBatchJob *job = new TSPBatchJob;
+	job->_batch = this;
+	job->_name = new char[strlen(name) + 1];
+	strcpy(job->_name, name);
+	job->_vertices.resize(vertices._count);
+	memcpy(job->_vertices._x, vertices._x, vertices._count * sizeof(float));
+	memcpy(job->_vertices._y, vertices._y, vertices._count * sizeof(float));
+	job->_vertices._metric = vertices._metric;
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (_inFlight >= _maxInFlight)
+			_room.wait(lock);
+		_inFlight++;
+		job->_index = _submitted++;
+	}
+	_pool.submit(solveTask, job);
+}
+
+void TSPBatch::finish() {
+	_pool.wait();
+}
+
+// an instance left the batch, wake a blocked submit()
+//
+void TSPBatch::release() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_inFlight--;
+	}
+	_room.notify_one();
+}
+
+// progress call back of the solves, called by the solving thread at the end of every generation,
+// stop the solver once the batch is stopped
+//
+void TSPBatch::solveProgress(const TSPSolver *solver, int, bool, void *data) {
+	if (((TSPBatch *)data)->stopped())
+		const_cast<TSPSolver *>(solver)->stop();
+}
+
+// pool task solving one instance, unless the batch is stopped
+//
+void TSPBatch::solveTask(void *data, int thread) {
+	TSPBatchJob *job = (TSPBatchJob *)data;
+	TSPBatch *self = job->_batch;
+	if (!self->stopped() && job->_vertices._count >= 2) {
+		TSPSolver *solver = TSPSolver::create(job->_vertices, self->_config);
+		solver->callback(solveProgress, self);
+		const TSPResult &result = solver->solve();
+		{
+			std::lock_guard<std::mutex> lock(self->_mutex);
+			self->_solved++;
+		}
+		if (self->_callback) {
+			TSPBatchResult out;
+			out._index = job->_index;
+			out._name = job->_name;
+			out._vtxCount = job->_vertices._count;
+			out._result = &result;
+			out._thread = thread;
+			std::lock_guard<std::mutex> lock(self->_callbackMutex);
+			self->_callback(out, self->_callbackData);
+		}
+		delete solver;
+	}
+	delete[] job->_name;
+	delete job;
+	self->release();
+}
+
+
+
+#endif /*__BATCH_H__*/
@@ -0,0 +1,364 @@
+// micro benchmarks of the GA kernels and of the whole generation loop,
+// every kernel is timed on random cities for several cities counts and population sizes
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "TSPSolver.h"
+
+#define __BENCH_Area_W 900			// width of the area the random cities are placed in
+#define __BENCH_Area_H 600			// height of the area the random cities are placed in
+#define __BENCH_SECONDS 0.2			// minimum time spent timing a kernel
+#define __BENCH_MAX_POP_BYTES 64000000	// larger populations are not benchmarked
+#define __BENCH_NEIGHBOURS 8			// neighbours count of the candidate lists
+#define __BENCH_QUALITY_SECONDS 1.0		// CPU time given to every crossover by the quality runs
+#define __BENCH_QUALITY_MAX_VTX 1000	// larger cities counts get no quality run
+
+
+typedef std::chrono::steady_clock GClock;
+
+double secondsSince(GClock::time_point start) {
+	return std::chrono::duration<double>(GClock::now() - start).count();
+}
+
+
+// write one result line, time per operation and operations per second
+//
+void report(const char *kernel, int vtxCount, int popCount, double seconds, long long ops) {
+	char pop[16] = "-";
+	if (popCount)
+		sprintf(pop, "%d", popCount);
+	printf("%-18s %8d %8s %14.1f %14.0f\n", kernel, vtxCount, pop, seconds * 1e9 / ops, ops / seconds);
+}
+
+
+// solver exposing its kernels to the benchmark, the population is prepared as solve() does it
+//
+template <typename TIdx>
+class TSPBenchSolver : public TSPSolverT<TIdx> {
+public:
+	TSPBenchSolver(const GVertexStore &vertices, const TSPConfig &config)
+		: TSPSolverT<TIdx>(vertices, config, NULL), _pool(1) {
+		this->_rng.seed(config._seed);
+		this->makeWorkers(1);
+		this->initiatePopulation(_pool);
+		this->_survivors = this->selectSurvivors(0);
+	}
+
+	void benchMutate(int vtxCount);
+	void benchSort(int vtxCount);
+	void benchSelect(int vtxCount);
+	void benchParents(int vtxCount);
+
+private:
+	void shuffleTours(int from);
+
+	GThreadPool _pool;
+};
+
+
+// shuffle the tours from the given index to the end of the population, so they need sorting again
+//
+template <typename TIdx>
+void TSPBenchSolver<TIdx>::shuffleTours(int from) {
+	this->_rng.shuffle(this->_toursPopulationList + from, this->_config._populationCount - from);
+}
+
+template <typename TIdx>
+void TSPBenchSolver<TIdx>::benchMutate(int vtxCount) {
+	TSPWorker<TIdx> &w = this->_workers[0];
+	GPath<TIdx> *tour = this->_toursPopulationList[0];
+	long long ops = 0;
+	GClock::time_point start = GClock::now();
+	do {
+		for (int i = 0; i < 64; i++)
+			this->mutate(w, tour);
+		ops += 64;
+	} while (secondsSince(start) < __BENCH_SECONDS);
+	report("mutate", vtxCount, 0, secondsSince(start), ops);
+}
+
+// full sort of a shuffled population, the mergeSort of sortTours(0)
+//
+template <typename TIdx>
+void TSPBenchSolver<TIdx>::benchSort(int vtxCount) {
+	double seconds = 0.0;
+	long long ops = 0;
+	do {
+		shuffleTours(0);
+		GClock::time_point start = GClock::now();
+		this->sortTours(0);
+		seconds += secondsSince(start);
+		ops++;
+	} while (seconds < __BENCH_SECONDS);
+	report("sortTours", vtxCount, this->_config._populationCount, seconds, ops);
+}
+
+// selection of a generation, the survivors are sorted and the children below them are in random order
+//
+template <typename TIdx>
+void TSPBenchSolver<TIdx>::benchSelect(int vtxCount) {
+	double seconds = 0.0;
+	long long ops = 0;
+	do {
+		this->sortTours(0);
+		int survivors = this->_survivors;
+		shuffleTours(survivors);
+		GClock::time_point start = GClock::now();
+		this->_survivors = this->selectSurvivors(survivors);
+		seconds += secondsSince(start);
+		ops++;
+	} while (seconds < __BENCH_SECONDS);
+	report("selectSurvivors", vtxCount, this->_config._populationCount, seconds, ops);
+}
+
+// parent draws of every selection scheme, ops are draws, the table of a generation is prepared before its draws
+//
+template <typename TIdx>
+void TSPBenchSolver<TIdx>::benchParents(int vtxCount) {
+	TSPWorker<TIdx> &w = this->_workers[0];
+	int draws = this->_config._populationCount - this->_survivors;
+	for (int type = 0; type < TSP_SELECT_COUNT; type++) {
+		TSPConfig config = this->_config;
+		config._selection = (TSPSelection)type;
+		config._tournamentSize = 4;
+		this->_parents.configure(config);
+		long long ops = 0;
+		int sum = 0;
+		GClock::time_point start = GClock::now();
+		do {
+			this->_parents.prepare(this->_toursPopulationList, this->_survivors);
+			for (int i = 0; i < draws; i++)
+				sum += this->_parents.draw(w._rng);
+			ops += draws;
+		} while (secondsSince(start) < __BENCH_SECONDS);
+		double seconds = secondsSince(start);
+		volatile int sink = sum;		// keeps the draws from being optimized away
+		(void)sink;
+		char name[64];
+		sprintf(name, "parents_%s", selectionName((TSPSelection)type));
+		report(name, vtxCount, this->_config._populationCount, seconds, ops);
+	}
+}
+
+
+
+// crossover of two parents into two children by the TCross policy, without the length evaluation
+//
+template <class TCross, typename TIdx>
+void benchCrossover(GCrossoverType type, const GPath<TIdx> &parent1, const GPath<TIdx> &parent2, GPath<TIdx> &child1, GPath<TIdx> &child2,
+	const GDistanceOracle &dist, const GNeighbours &neighbours, GRandom &rng) {
+	int vtxCount = dist.vtxCount();
+	GCrossoverScratch<TIdx> scratch;
+	scratch.allocate(vtxCount, type);
+	scratch.candidates(neighbours.lists(), neighbours.count());
+	char name[32];
+	sprintf(name, "crossover_%s", crossoverName(type));
+	long long ops = 0;
+	GClock::time_point start = GClock::now();
+	do {
+		TCross::cross(parent1._path, parent2._path, child1._path, child2._path, scratch, vtxCount, rng, dist);
+		ops++;
+	} while (secondsSince(start) < __BENCH_SECONDS);
+	report(name, vtxCount, 0, secondsSince(start), ops);
+}
+
+
+// kernels working on single tours, length evaluation, crossover, nearest neighbour tour and local search
+//
+template <typename TIdx>
+void benchTourKernels(const GVertexStore &vertices, const GDistanceOracle &dist, const GNeighbours &neighbours) {
+	int vtxCount = vertices._count;
+	GRandom rng(1);
+	TIdx *genes = new TIdx[4 * vtxCount];
+	GPath<TIdx> parent1, parent2, child1, child2;
+	parent1._path = genes;
+	parent2._path = genes + vtxCount;
+	child1._path = genes + 2 * vtxCount;
+	child2._path = genes + 3 * vtxCount;
+	for (int i = 0; i < vtxCount; i++)
+		parent1._path[i] = parent2._path[i] = (TIdx)i;
+	rng.shuffle(parent1._path, vtxCount);
+	rng.shuffle(parent2._path, vtxCount);
+	// full length evaluation, reported per tour, a tour is vtxCount edges, by every kernel the CPU supports
+	//
+	long long ops;
+	GClock::time_point start;
+	for (int level = G_SIMD_SCALAR; level <= __simdLevel; level++) {
+		char name[32];
+		sprintf(name, "length_%s", simdLevelName((GSimdLevel)level));
+		ops = 0;
+		start = GClock::now();
+		do {
+			parent1._length = dist.tourLength(parent1._path, (GSimdLevel)level);
+			ops++;
+		} while (secondsSince(start) < __BENCH_SECONDS);
+		report(name, vtxCount, 0, secondsSince(start), ops);
+	}
+	// every crossover on the same random parents
+	//
+	benchCrossover<GCrossoverCX>(G_CROSSOVER_CX, parent1, parent2, child1, child2, dist, neighbours, rng);
+	benchCrossover<GCrossoverOX>(G_CROSSOVER_OX, parent1, parent2, child1, child2, dist, neighbours, rng);
+	benchCrossover<GCrossoverPMX>(G_CROSSOVER_PMX, parent1, parent2, child1, child2, dist, neighbours, rng);
+	benchCrossover<GCrossoverERX>(G_CROSSOVER_ERX, parent1, parent2, child1, child2, dist, neighbours, rng);
+	benchCrossover<GCrossoverEAX>(G_CROSSOVER_EAX, parent1, parent2, child1, child2, dist, neighbours, rng);
+	// nearest neighbour tour from a random city, then its local search to a 2-opt and Or-opt local optimum
+	// on the neighbour candidate lists
+	//
+	char *visited = new char[vtxCount];
+	int *left = new int[neighbours.index().cellCount()];
+	GLocalSearch<TIdx> ls;
+	ls.allocate(vtxCount);
+	ls.candidates(neighbours.lists(), neighbours.count());
+	double nnSeconds = 0.0, lsSeconds = 0.0;
+	ops = 0;
+	do {
+		start = GClock::now();
+		nearestNeighbourTour(neighbours, vtxCount, rng.below(vtxCount), child1._path, visited, left);
+		nnSeconds += secondsSince(start);
+		child1.updateLength(dist);
+		start = GClock::now();
+		ls.optimize(&child1, dist);
+		lsSeconds += secondsSince(start);
+		ops++;
+	} while (nnSeconds + lsSeconds < __BENCH_SECONDS);
+	report("nearestNeighbour", vtxCount, 0, nnSeconds, ops);
+	report("localSearch", vtxCount, 0, lsSeconds, ops);
+	delete[] visited;
+	delete[] left;
+	delete[] genes;
+}
+
+
+// kernels working on a population, mutation, sort, selection and parent draws, for the given population sizes
+//
+template <typename TIdx>
+void benchPopulationKernels(const GVertexStore &vertices, const int *popCounts, int popCountsCount) {
+	int vtxCount = vertices._count;
+	for (int p = 0; p < popCountsCount; p++) {
+		if ((double)popCounts[p] * vtxCount * sizeof(TIdx) > __BENCH_MAX_POP_BYTES)
+			continue;
+		TSPConfig config;
+		config._populationCount = popCounts[p];
+		config._seed = 1;
+		TSPBenchSolver<TIdx> solver(vertices, config);
+		if (p == 0)
+			solver.benchMutate(vtxCount);
+		solver.benchSort(vtxCount);
+		solver.benchSelect(vtxCount);
+		solver.benchParents(vtxCount);
+	}
+}
+
+
+// end to end generation loop, ops are generations, the evaluations per second are written after them,
+// the small instances are solved by the fixed size solver unless general is set, packed stores the population bit packed
+//
+void benchSolve(const GVertexStore &vertices, int popCount, int threadCount, bool general = false, bool packed = false) {
+	int vtxCount = vertices._count;
+	if ((double)popCount * vtxCount * sizeof(unsigned) > __BENCH_MAX_POP_BYTES)
+		return;
+	TSPConfig config;
+	config._populationCount = popCount;
+	config._mutationProb = 0.01f;
+	config._seed = 1;
+	config._threadCount = threadCount;
+	config._generationIter = (int)(2e7 / ((double)vtxCount * popCount)) + 5;
+	config._smallSolver = !general;
+	config._packedTours = packed;
+	TSPSolver *solver = TSPSolver::create(vertices, config);
+	const TSPResult &result = solver->solve();
+	// every generation evaluates about half the population, the children replacing the loosers
+	//
+	double evals = (double)result._generations * popCount / 2;
+	printf("%-18s %8d %8d %14.1f %14.0f  (%.0f evals/s)\n", packed ? "generation_packed" : general ? "generation_general" : "generation", vtxCount, popCount,
+		result._seconds * 1e9 / result._generations, result._generations / result._seconds, evals / result._seconds);
+	delete solver;
+}
+
+
+// quality of every crossover for the same CPU time, one thread solving the same cities from the same seed until the time limit,
+// ops are generations, the best tour length is written after them
+//
+void benchCrossoverQuality(const GVertexStore &vertices, int popCount) {
+	int vtxCount = vertices._count;
+	for (int type = 0; type < G_CROSSOVER_COUNT; type++) {
+		TSPConfig config;
+		config._populationCount = popCount;
+		config._mutationProb = 0.01f;
+		config._seed = 1;
+		config._generationIter = 0;
+		config._timeLimit = __BENCH_QUALITY_SECONDS;
+		config._crossover = (GCrossoverType)type;
+		TSPSolver *solver = TSPSolver::create(vertices, config);
+		const TSPResult &result = solver->solve();
+		char name[32];
+		sprintf(name, "quality_%s", crossoverName(solver->config()._crossover));
+		printf("%-18s %8d %8d %14.1f %14.0f  (best %.1f)\n", name, vtxCount, popCount,
+			result._seconds * 1e9 / result._generations, result._generations / result._seconds, result._bestTour->_length);
+		delete solver;
+	}
+}
+
+
+// print the command line usage
+//
+void usage(const char *prog) {
+	fprintf(stderr,
+		"usage: %s [options]\n"
+		"  -q            quick run, skips the 100000 cities\n"
+		"  -j <count>    worker threads of the generation loop, 0 uses every hardware thread (default 1)\n", prog);
+}
+
+
+int main(int argc, char **argv) {
+	bool quick = false;
+	int threadCount = 1;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-q"))
+			quick = true;
+		else if (i + 1 < argc && !strcmp(argv[i], "-j"))
+			threadCount = atoi(argv[++i]);
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	const int vtxCounts[] = { 50, 1000, 10000, 100000 };
+	const int popCounts[] = { 100, 1000, 10000 };
+	int vtxCountsCount = quick ? 3 : 4;
+	int popCountsCount = sizeof(popCounts) / sizeof(popCounts[0]);
+	printf("%-18s %8s %8s %14s %14s\n", "kernel", "cities", "tours", "ns/op", "ops/s");
+	for (int v = 0; v < vtxCountsCount; v++) {
+		GRandom rng(1);
+		GVertexStore vertices;
+		randomVertices(vertices, vtxCounts[v], __BENCH_Area_W, __BENCH_Area_H, rng);
+		GDistanceOracle dist(vertices);
+		GClock::time_point start = GClock::now();
+		GNeighbours neighbours(vertices, __BENCH_NEIGHBOURS);
+		report("neighbourLists", vtxCounts[v], 0, secondsSince(start), 1);
+		if (vertices._count <= __IDX8_MAX_VTX__) {
+			benchTourKernels<unsigned char>(vertices, dist, neighbours);
+			benchPopulationKernels<unsigned char>(vertices, popCounts, popCountsCount);
+		}
+		else if (vertices._count <= __IDX16_MAX_VTX__) {
+			benchTourKernels<unsigned short>(vertices, dist, neighbours);
+			benchPopulationKernels<unsigned short>(vertices, popCounts, popCountsCount);
+		}
+		else {
+			benchTourKernels<unsigned>(vertices, dist, neighbours);
+			benchPopulationKernels<unsigned>(vertices, popCounts, popCountsCount);
+		}
+		for (int p = 0; p < popCountsCount; p++) {
+			benchSolve(vertices, popCounts[p], threadCount);
+			if (vtxCounts[v] <= __SMALL_MAX_VTX__)
+				benchSolve(vertices, popCounts[p], threadCount, true);
+			else
+				benchSolve(vertices, popCounts[p], threadCount, true, true);
+		}
+		if (vtxCounts[v] <= __BENCH_QUALITY_MAX_VTX)
+			benchCrossoverQuality(vertices, popCounts[1]);
+	}
+	return 0;
+}
@@ -0,0 +1,209 @@
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#endif
+
+#include "TSPLIB.h"
+
+#define __CHECKPOINT_MAGIC__ "TSPGACKP"		// first 8 bytes of a checkpoint file
+#define __CHECKPOINT_VERSION__ 1			// layout version, older or newer files are rejected
+#define __CHECKPOINT_SECTIONS__ 8			// most sections of a file
+#define __CHECKPOINT_ALIGN__ 64				// sections start on cache line boundaries, so a mapped file is read in place
+
+
+// header at the start of a checkpoint file, the offset and size of every section,
+// the sections themselves are raw arrays in the byte order of the machine which wrote them
+//
+struct GCheckpointHeader {
+	char _magic[8];										// __CHECKPOINT_MAGIC__
+	unsigned _version;									// __CHECKPOINT_VERSION__
+	unsigned _sectionCount;								// sections in the file
+	unsigned long long _fileSize;						// bytes of the whole file, a shorter file was cut while written
+	unsigned long long _offsets[__CHECKPOINT_SECTIONS__];	// first byte of every section
+	unsigned long long _sizes[__CHECKPOINT_SECTIONS__];	// bytes of every section
+};
+
+
+
+// writer of a checkpoint file, the sections are written to a temporary file which replaces the checkpoint
+// only once complete and flushed to the disk, so a run killed while writing keeps its previous checkpoint
+//
+class GCheckpointWriter {
+public:
+	GCheckpointWriter() : _file(NULL), _path(NULL), _tmpPath(NULL), _offset(0) {}
+	~GCheckpointWriter() { discard(); }
+
+	bool begin(const char *path);						// start a new checkpoint of the given file
+	bool section(const void *data, size_t bytes);		// start the next section with the given bytes
+	bool write(const void *data, size_t bytes);			// append the given bytes to the current section
+	bool commit();										// complete the file and replace the checkpoint by it
+	void discard();										// drop the temporary file
+
+private:
+	GCheckpointWriter(const GCheckpointWriter &);
+	GCheckpointWriter &operator=(const GCheckpointWriter &);
+
+	FILE *_file;					// temporary file, NULL if no checkpoint is being written
+	const char *_path;				// checkpoint file
+	char *_tmpPath;					// temporary file name, the checkpoint file name with .tmp
+	GCheckpointHeader _header;		// header written once the sections are known
+	unsigned long long _offset;		// bytes written so far
+};
+
+
+bool GCheckpointWriter::begin(const char *path) {
+	discard();
+	_path = path;
+	_tmpPath = new char[strlen(path) + 5];
+	sprintf(_tmpPath, "%s.tmp", path);
+	_file = fopen(_tmpPath, "wb");
+	if (!_file)
+		return false;
+	memset(&_header, 0, sizeof(_header));
+	memcpy(_header._magic, __CHECKPOINT_MAGIC__, sizeof(_header._magic));
+	_header._version = __CHECKPOINT_VERSION__;
+	// the header is written again by commit(), with the final offsets
+	//
+	_offset = 0;
+	return write(&_header, sizeof(_header));
+}
+
+bool GCheckpointWriter::section(const void *data, size_t bytes) {
+	if (!_file || _header._sectionCount == __CHECKPOINT_SECTIONS__)
+		return false;
+	static const char padding[__CHECKPOINT_ALIGN__] = { 0 };
+	size_t pad = (size_t)((__CHECKPOINT_ALIGN__ - _offset % __CHECKPOINT_ALIGN__) % __CHECKPOINT_ALIGN__);
+	if (pad && fwrite(padding, 1, pad, _file) != pad) {
+		discard();
+		return false;
+	}
+	_offset += pad;
+	_header._offsets[_header._sectionCount] = _offset;
+	_header._sizes[_header._sectionCount] = 0;
+	_header._sectionCount++;
+	return write(data, bytes);
+}
+
+bool GCheckpointWriter::write(const void *data, size_t bytes) {
+	if (!_file)
+		return false;
+	if (bytes && fwrite(data, 1, bytes, _file) != bytes) {
+		discard();
+		return false;
+	}
+	_offset += bytes;
+	if (_header._sectionCount)
+		_header._sizes[_header._sectionCount - 1] += bytes;
+	return true;
+}
+
+bool GCheckpointWriter::commit() {
+	if (!_file)
+		return false;
+	_header._fileSize = _offset;
+	bool ok = fseek(_file, 0, SEEK_SET) == 0 && fwrite(&_header, sizeof(_header), 1, _file) == 1 && fflush(_file) == 0;
+	// the data must be on the disk before the rename makes it the checkpoint
+	//
+#ifdef _WIN32
+	ok = ok && _commit(_fileno(_file)) == 0;
+#else
+	ok = ok && fsync(fileno(_file)) == 0;
+#endif
+	ok = fclose(_file) == 0 && ok;
+	_file = NULL;
+	if (ok) {
+#ifdef _WIN32
+		ok = MoveFileExA(_tmpPath, _path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+		ok = rename(_tmpPath, _path) == 0;
+#endif
+	}
+	if (!ok)
+		remove(_tmpPath);
+	delete[] _tmpPath;
+	_tmpPath = NULL;
+	return ok;
+}
+
+void GCheckpointWriter::discard() {
+	if (_file) {
+		fclose(_file);
+		_file = NULL;
+		remove(_tmpPath);
+	}
+	delete[] _tmpPath;
+	_tmpPath = NULL;
+}
+
+
+
+// checkpoint file mapped in memory, the sections are read in place
+//
+class GCheckpoint {
+public:
+	GCheckpoint() : _header(NULL) {}
+
+	bool open(const char *path, const char **error);	// map and check the given file, return false and set error if it is no checkpoint
+	void close() { _file.close(); _header = NULL; }
+	bool isOpen() const { return _header != NULL; }
+
+	// section i if it has the given size in bytes, NULL otherwise
+	//
+	const void *section(unsigned i, size_t bytes) const {
+		if (!_header || i >= _header->_sectionCount || _header->_sizes[i] != bytes)
+			return NULL;
+		return _file.data() + _header->_offsets[i];
+	}
+
+private:
+	GCheckpoint(const GCheckpoint &);
+	GCheckpoint &operator=(const GCheckpoint &);
+
+	GMappedFile _file;					// mapping of the whole file
+	const GCheckpointHeader *_header;	// header at the start of the mapping, NULL if no file is open
+};
+
+
+bool GCheckpoint::open(const char *path, const char **error) {
+	close();
+	if (!_file.open(path)) {
+		*error = "can not open the checkpoint";
+		return false;
+	}
+	const GCheckpointHeader *header = (const GCheckpointHeader *)_file.data();
+	if (_file.size() < sizeof(GCheckpointHeader) || memcmp(header->_magic, __CHECKPOINT_MAGIC__, sizeof(header->_magic))) {
+		*error = "not a checkpoint";
+		_file.close();
+		return false;
+	}
+	if (header->_version != __CHECKPOINT_VERSION__ || header->_sectionCount > __CHECKPOINT_SECTIONS__) {
+		*error = "unsupported checkpoint version";
+		_file.close();
+		return false;
+	}
+	if (header->_fileSize != _file.size()) {
+		*error = "truncated checkpoint";
+		_file.close();
+		return false;
+	}
+	for (unsigned i = 0; i < header->_sectionCount; i++) {
+		if (header->_offsets[i] > _file.size() || header->_sizes[i] > _file.size() - header->_offsets[i]) {
+			*error = "corrupted checkpoint";
+			_file.close();
+			return false;
+		}
+	}
+	_header = header;
+	return true;
+}
+
+
+
+#endif /*__CHECKPOINT_H__*/
@@ -0,0 +1,495 @@
+#ifndef __CROSSOVER_H__
+#define __CROSSOVER_H__
+
+
+
+#include <cstring>
+#include <cfloat>
+
+#include "Random.h"
+#include "DistanceOracle.h"
+
+
+// crossover operator of the GA
+//
+enum GCrossoverType {
+	G_CROSSOVER_CX,			// cycle crossover, every gene keeps the position it has in one of the parents
+	G_CROSSOVER_OX,			// order crossover, a segment of one parent, then the other cities in the order of the other parent
+	G_CROSSOVER_PMX,		// partially mapped crossover, a segment of one parent, the other genes of the other parent mapped through it
+	G_CROSSOVER_ERX,		// edge recombination, a tour walking the edges of both parents
+	G_CROSSOVER_EAX,		// edge assembly, one parent with an alternating cycle of edges of the other, subtours merged greedily
+	G_CROSSOVER_COUNT
+};
+
+const char *crossoverName(GCrossoverType type) {
+	static const char *names[G_CROSSOVER_COUNT] = { "cx", "ox", "pmx", "erx", "eax" };
+	return names[type];
+}
+
+// crossover operator of the given name, return false if no operator has it
+//
+bool crossoverByName(const char *name, GCrossoverType &type) {
+	for (int t = 0; t < G_CROSSOVER_COUNT; t++)
+		if (!strcmp(name, crossoverName((GCrossoverType)t))) {
+			type = (GCrossoverType)t;
+			return true;
+		}
+	return false;
+}
+
+
+// scratch buffers of the crossovers, owned by one thread, only those of the given operator are allocated.
+// the edge assembly takes its merge candidates from the neighbour lists given to candidates(), or every city if there are none
+//
+template <typename TIdx>
+struct GCrossoverScratch {
+	GCrossoverScratch() : _pos1(NULL), _pos2(NULL), _used(NULL), _adj(NULL), _adjCount(NULL), _order(NULL), _where(NULL),
+		_link(NULL), _compSize(NULL), _compStart(NULL), _neighbours(NULL), _neighbourCount(0) {}
+	~GCrossoverScratch() { clear(); }
+
+	void allocate(int vtxCount, GCrossoverType type);
+	void clear();
+	void candidates(const int *neighbours, int neighbourCount) { _neighbours = neighbours; _neighbourCount = neighbourCount; }
+
+	TIdx *_pos1;				// inverse "city -> position" index of the first parent
+	TIdx *_pos2;				// inverse index of the second parent
+	char *_used;				// city flags
+	TIdx *_adj;					// 4 adjacent cities of every city
+	unsigned char *_adjCount;	// adjacent cities counts, 2 per city
+	int *_order;				// city list, or the vertices of an alternating cycle, 2 * vtxCount + 2 entries
+	int *_where;				// position of every city in the city list, or its subtour
+	int *_link;					// 2 adjacent cities of every city in the child under assembly
+	int *_compSize;				// cities count of every subtour
+	int *_compStart;			// a city of every subtour
+	const int *_neighbours;		// neighbour lists of the cities, NULL to try every city
+	int _neighbourCount;		// neighbours count of every list
+
+private:
+	GCrossoverScratch(const GCrossoverScratch &);
+	GCrossoverScratch &operator=(const GCrossoverScratch &);
+};
+
+
+template <typename TIdx>
+void GCrossoverScratch<TIdx>::allocate(int vtxCount, GCrossoverType type) {
+	clear();
+	_pos1 = new TIdx[vtxCount];
+	if (type == G_CROSSOVER_OX || type == G_CROSSOVER_PMX)
+		_used = new char[vtxCount];
+	if (type == G_CROSSOVER_ERX || type == G_CROSSOVER_EAX) {
+		_adj = new TIdx[4 * vtxCount];
+		_adjCount = new unsigned char[2 * vtxCount];
+		_order = new int[2 * vtxCount + 2];
+		_where = new int[vtxCount];
+	}
+	if (type == G_CROSSOVER_EAX) {
+		_pos2 = new TIdx[vtxCount];
+		_link = new int[2 * vtxCount];
+		_compSize = new int[vtxCount];
+		_compStart = new int[vtxCount];
+	}
+}
+
+template <typename TIdx>
+void GCrossoverScratch<TIdx>::clear() {
+	delete[] _pos1; delete[] _pos2; delete[] _used; delete[] _adj; delete[] _adjCount;
+	delete[] _order; delete[] _where; delete[] _link; delete[] _compSize; delete[] _compStart;
+	_pos1 = _pos2 = _adj = NULL;
+	_used = NULL;
+	_adjCount = NULL;
+	_order = _where = _link = _compSize = _compStart = NULL;
+}
+
+
+
+// function to Cycle crossover, CX, of two parent tours of vtxCount cities,
+// children are written into the caller buffers, child2 may be NULL when only one child is needed,
+// pos is a caller scratch buffer of vtxCount entries holding the inverse "city -> position" index of parent1,
+// so every cycle step is a lookup and the whole crossover runs in O(n)
+//
+template <typename TIdx>
+void CX_crossover(const TIdx *parent1, const TIdx *parent2, TIdx *child1, TIdx *child2, TIdx *pos, int vtxCount) {
+	int h = 0;
+	// iterate through the parents genes to find the first inequal gene,
+	// if the parents are equal h stays on the last gene and the cycle is this gene alone
+	//
+	while (h < vtxCount - 1 && parent1[h] == parent2[h])
+		h++;
+	// build the inverse index of parent1
+	//
+	for (int i = 0; i < vtxCount; i++)
+		pos[parent1[i]] = (TIdx)i;
+	// children start as copies of the other parent, the cycle genes are then taken from their own parent
+	//
+	memcpy(child1, parent2, vtxCount * sizeof(TIdx));
+	if (child2)
+		memcpy(child2, parent1, vtxCount * sizeof(TIdx));
+	// start from h, the first inequal gene, and follow the cycle by cyclically mapping the common city Ids
+	//
+	int k = h;
+	do {
+		child1[k] = parent1[k];
+		if (child2)
+			child2[k] = parent2[k];
+		k = pos[parent2[k]];
+	} while (k != h);
+}
+
+
+// function to Order crossover, OX, the child keeps the genes a..b of parent1 in place, the positions after b are filled,
+// cyclically, with the other cities in their order in parent2 from b + 1, used is a scratch of vtxCount flags
+//
+template <typename TIdx>
+void OX_crossover(const TIdx *parent1, const TIdx *parent2, TIdx *child, char *used, int a, int b, int vtxCount) {
+	memset(used, 0, vtxCount);
+	for (int i = a; i <= b; i++) {
+		child[i] = parent1[i];
+		used[parent1[i]] = 1;
+	}
+	int k = b + 1 == vtxCount ? 0 : b + 1;
+	for (int i = 0, j = k; i < vtxCount; i++) {
+		TIdx c = parent2[j];
+		if (++j == vtxCount)
+			j = 0;
+		if (!used[c]) {
+			child[k] = c;
+			if (++k == vtxCount)
+				k = 0;
+		}
+	}
+}
+
+
+// function to Partially mapped crossover, PMX, the child keeps the genes a..b of parent1 in place, the other genes come from
+// parent2, a city of parent2 already in the segment is mapped to the city of parent2 at its segment position until it is not,
+// pos is a scratch of the positions of the segment cities, used a scratch of vtxCount flags
+//
+template <typename TIdx>
+void PMX_crossover(const TIdx *parent1, const TIdx *parent2, TIdx *child, TIdx *pos, char *used, int a, int b, int vtxCount) {
+	memset(used, 0, vtxCount);
+	for (int i = a; i <= b; i++) {
+		child[i] = parent1[i];
+		used[parent1[i]] = 1;
+		pos[parent1[i]] = (TIdx)i;
+	}
+	for (int i = 0; i < vtxCount; i++) {
+		if (i == a) {
+			i = b;
+			continue;
+		}
+		TIdx c = parent2[i];
+		while (used[c])
+			c = parent2[pos[c]];
+		child[i] = c;
+	}
+}
+
+
+// function to Edge recombination crossover, ERX, the child starts from the given city and always goes on to the adjacent city,
+// in either parent, with the fewest adjacent cities left, ties broken at random, or to a random city left when there is none
+//
+template <typename TIdx>
+void ERX_crossover(const TIdx *parent1, const TIdx *parent2, TIdx *child, GCrossoverScratch<TIdx> &s, int start, int vtxCount, GRandom &rng) {
+	TIdx *adj = s._adj;
+	unsigned char *count = s._adjCount;
+	memset(count, 0, vtxCount);
+	// adjacency of the union of the parent edges, at most 4 cities each
+	//
+	for (int p = 0; p < 2; p++) {
+		const TIdx *parent = p ? parent2 : parent1;
+		for (int i = 0; i < vtxCount; i++) {
+			int c = parent[i];
+			int d = parent[i + 1 == vtxCount ? 0 : i + 1];
+			if (c == d)
+				continue;
+			int k = 0;
+			while (k < count[c] && (int)adj[4 * c + k] != d)
+				k++;
+			if (k == count[c]) {
+				adj[4 * c + count[c]++] = (TIdx)d;
+				adj[4 * d + count[d]++] = (TIdx)c;
+			}
+		}
+	}
+	// cities left, with their list positions, so a city is removed in O(1)
+	//
+	int *left = s._order;
+	int *where = s._where;
+	for (int i = 0; i < vtxCount; i++)
+		left[i] = where[i] = i;
+	int leftCount = vtxCount;
+	int cur = start;
+	for (int step = 0; step < vtxCount; step++) {
+		child[step] = (TIdx)cur;
+		int last = left[--leftCount];
+		left[where[cur]] = last;
+		where[last] = where[cur];
+		// the city is no more a candidate of its adjacent cities
+		//
+		for (int k = 0; k < count[cur]; k++) {
+			int m = adj[4 * cur + k];
+			int l = 0;
+			while ((int)adj[4 * m + l] != cur)
+				l++;
+			adj[4 * m + l] = adj[4 * m + --count[m]];
+		}
+		if (!leftCount)
+			break;
+		int next = -1, best = 5, ties = 0;
+		for (int k = 0; k < count[cur]; k++) {
+			int m = adj[4 * cur + k];
+			if (count[m] < best) {
+				best = count[m];
+				next = m;
+				ties = 1;
+			}
+			else if (count[m] == best && rng.below(++ties) == 0)
+				next = m;
+		}
+		cur = next >= 0 ? next : left[rng.below(leftCount)];
+	}
+}
+
+
+// function to Edge assembly crossover, EAX, with a single alternating cycle: the edges of base not in other and of other
+// not in base alternate around every city, a random walk over them closes an AB-cycle, the child is base with the base
+// edges of the cycle replaced by its other edges. this splits the child into subtours, the smallest subtour is then
+// merged into the one of a candidate city by the 2-opt exchange of an edge of each with the lowest length increase
+//
+template <typename TIdx>
+void EAX_crossover(const TIdx *base, const TIdx *other, TIdx *child, GCrossoverScratch<TIdx> &s, int vtxCount, GRandom &rng, const GDistanceOracle &dist) {
+	if (vtxCount < 5) {
+		memcpy(child, base, vtxCount * sizeof(TIdx));
+		return;
+	}
+	TIdx *adj = s._adj;
+	unsigned char *count = s._adjCount;
+	int *link = s._link;
+	memset(count, 0, 2 * vtxCount);
+	for (int i = 0; i < vtxCount; i++) {
+		s._pos1[base[i]] = (TIdx)i;
+		s._pos2[other[i]] = (TIdx)i;
+	}
+	// edges of each parent not in the other one, those of base in the slots 0 and 1 of the cities, those of other in 2 and 3,
+	// and the links of the child, the base tour
+	//
+	int edges = 0;
+	for (int p = 0; p < 2; p++) {
+		const TIdx *tour = p ? other : base;
+		const TIdx *tour2 = p ? base : other;
+		const TIdx *pos2 = p ? s._pos1 : s._pos2;
+		for (int i = 0; i < vtxCount; i++) {
+			int c = tour[i];
+			int d = tour[i + 1 == vtxCount ? 0 : i + 1];
+			if (!p) {
+				link[2 * c + 1] = d;
+				link[2 * d] = c;
+			}
+			int j = pos2[c];
+			if ((int)tour2[j + 1 == vtxCount ? 0 : j + 1] == d || (int)tour2[j == 0 ? vtxCount - 1 : j - 1] == d)
+				continue;
+			adj[4 * c + 2 * p + count[2 * c + p]++] = (TIdx)d;
+			adj[4 * d + 2 * p + count[2 * d + p]++] = (TIdx)c;
+			edges++;
+		}
+	}
+	if (!edges) {
+		memcpy(child, base, vtxCount * sizeof(TIdx));
+		return;
+	}
+	// walk the AB-cycle from a random city with a base edge, alternating base and other edges, each used once,
+	// until the walk is back on its first city by an edge of other. every city has as many edges of both kinds, so the walk
+	// never gets stuck, and the closed walk keeps two links on every city once applied
+	//
+	int v0 = rng.below(vtxCount);
+	while (!count[2 * v0])
+		v0 = v0 + 1 == vtxCount ? 0 : v0 + 1;
+	int *cycle = s._order;
+	int len = 0;
+	int cur = v0;
+	cycle[0] = v0;
+	for (int p = 0; ; p ^= 1) {
+		int k = rng.below(count[2 * cur + p]);
+		int next = adj[4 * cur + 2 * p + k];
+		adj[4 * cur + 2 * p + k] = adj[4 * cur + 2 * p + --count[2 * cur + p]];
+		int l = 0;
+		while ((int)adj[4 * next + 2 * p + l] != cur)
+			l++;
+		adj[4 * next + 2 * p + l] = adj[4 * next + 2 * p + --count[2 * next + p]];
+		cycle[++len] = cur = next;
+		if (p == 1 && cur == v0)
+			break;
+	}
+	// remove the base edges of the cycle from the child, then add its other edges in the freed links
+	//
+	for (int i = 0; i < len; i += 2)
+		for (int e = 0; e < 2; e++) {
+			int u = cycle[i + e], v = cycle[i + 1 - e];
+			link[2 * u + (link[2 * u] == v ? 0 : 1)] = -1;
+		}
+	for (int i = 1; i < len; i += 2)
+		for (int e = 0; e < 2; e++) {
+			int u = cycle[i + e], v = cycle[i + 1 - e];
+			link[2 * u + (link[2 * u] == -1 ? 0 : 1)] = v;
+		}
+	// label the subtours of the child
+	//
+	int *comp = s._where;
+	for (int i = 0; i < vtxCount; i++)
+		comp[i] = -1;
+	int compCount = 0;
+	for (int c = 0; c < vtxCount; c++) {
+		if (comp[c] >= 0)
+			continue;
+		int prev = link[2 * c + 1], u = c, size = 0;
+		do {
+			comp[u] = compCount;
+			size++;
+			int next = link[2 * u] == prev ? link[2 * u + 1] : link[2 * u];
+			prev = u;
+			u = next;
+		} while (u != c);
+		s._compSize[compCount] = size;
+		s._compStart[compCount++] = c;
+	}
+	// merge the smallest subtour into another one until a single tour is left
+	//
+	for (int merges = compCount - 1; merges > 0; merges--) {
+		int m = -1;
+		for (int i = 0; i < compCount; i++)
+			if (s._compSize[i] > 0 && (m < 0 || s._compSize[i] < s._compSize[m]))
+				m = i;
+		int bestU = -1, bestU2 = -1, bestV = -1, bestW = -1;
+		float bestCost = FLT_MAX;
+		for (int pass = 0; pass < 2 && bestU < 0; pass++) {
+			// the neighbour lists first, every city if none of them is outside the subtour
+			//
+			int candidateCount = pass == 0 && s._neighbours ? s._neighbourCount : vtxCount;
+			if (pass == 1 && !s._neighbours)
+				break;
+			int start = s._compStart[m];
+			int prev = link[2 * start + 1], u = start;
+			do {
+				for (int e = 0; e < 2; e++) {
+					int u2 = link[2 * u + e];
+					float removed = dist(u, u2);
+					for (int k = 0; k < candidateCount; k++) {
+						int v = pass == 0 && s._neighbours ? s._neighbours[u * s._neighbourCount + k] : k;
+						if (comp[v] == m)
+							continue;
+						for (int f = 0; f < 2; f++) {
+							int w = link[2 * v + f];
+							float base2 = removed + dist(v, w);
+							float cost = dist(u, v) + dist(u2, w) - base2;
+							if (cost < bestCost) {
+								bestCost = cost;
+								bestU = u; bestU2 = u2; bestV = v; bestW = w;
+							}
+							cost = dist(u, w) + dist(u2, v) - base2;
+							if (cost < bestCost) {
+								bestCost = cost;
+								bestU = u; bestU2 = u2; bestV = w; bestW = v;
+							}
+						}
+					}
+				}
+				int next = link[2 * u] == prev ? link[2 * u + 1] : link[2 * u];
+				prev = u;
+				u = next;
+			} while (u != start);
+		}
+		// relabel the subtour, then exchange (u, u2) and (v, w) for (u, v) and (u2, w)
+		//
+		int target = comp[bestV];
+		int start = s._compStart[m];
+		int prev = link[2 * start + 1], u = start;
+		do {
+			comp[u] = target;
+			int next = link[2 * u] == prev ? link[2 * u + 1] : link[2 * u];
+			prev = u;
+			u = next;
+		} while (u != start);
+		s._compSize[target] += s._compSize[m];
+		s._compSize[m] = 0;
+		link[2 * bestU + (link[2 * bestU] == bestU2 ? 0 : 1)] = bestV;
+		link[2 * bestU2 + (link[2 * bestU2] == bestU ? 0 : 1)] = bestW;
+		link[2 * bestV + (link[2 * bestV] == bestW ? 0 : 1)] = bestU;
+		link[2 * bestW + (link[2 * bestW] == bestV ? 0 : 1)] = bestU2;
+	}
+	// write the child from the links
+	//
+	int prev = link[1], u = 0;
+	for (int i = 0; i < vtxCount; i++) {
+		child[i] = (TIdx)u;
+		int next = link[2 * u] == prev ? link[2 * u + 1] : link[2 * u];
+		prev = u;
+		u = next;
+	}
+}
+
+
+
+// crossover policies, the solver instantiates its offspring loop for each of them, so the operator call is inlined in it.
+// cross() makes child1 from parent1 and child2, which may be NULL, from parent2, both of vtxCount cities,
+// with the scratch buffers allocated for the _type of the policy
+//
+struct GCrossoverCX {
+	static const GCrossoverType _type = G_CROSSOVER_CX;
+
+	template <typename TIdx>
+	static void cross(const TIdx *parent1, const TIdx *parent2, TIdx *child1, TIdx *child2, GCrossoverScratch<TIdx> &s, int vtxCount, GRandom &, const GDistanceOracle &) {
+		CX_crossover(parent1, parent2, child1, child2, s._pos1, vtxCount);
+	}
+};
+
+struct GCrossoverOX {
+	static const GCrossoverType _type = G_CROSSOVER_OX;
+
+	template <typename TIdx>
+	static void cross(const TIdx *parent1, const TIdx *parent2, TIdx *child1, TIdx *child2, GCrossoverScratch<TIdx> &s, int vtxCount, GRandom &rng, const GDistanceOracle &) {
+		int a = rng.below(vtxCount), b = rng.below(vtxCount);
+		if (a > b) { int t = a; a = b; b = t; }
+		OX_crossover(parent1, parent2, child1, s._used, a, b, vtxCount);
+		if (child2)
+			OX_crossover(parent2, parent1, child2, s._used, a, b, vtxCount);
+	}
+};
+
+struct GCrossoverPMX {
+	static const GCrossoverType _type = G_CROSSOVER_PMX;
+
+	template <typename TIdx>
+	static void cross(const TIdx *parent1, const TIdx *parent2, TIdx *child1, TIdx *child2, GCrossoverScratch<TIdx> &s, int vtxCount, GRandom &rng, const GDistanceOracle &) {
+		int a = rng.below(vtxCount), b = rng.below(vtxCount);
+		if (a > b) { int t = a; a = b; b = t; }
+		PMX_crossover(parent1, parent2, child1, s._pos1, s._used, a, b, vtxCount);
+		if (child2)
+			PMX_crossover(parent2, parent1, child2, s._pos1, s._used, a, b, vtxCount);
+	}
+};
+
+struct GCrossoverERX {
+	static const GCrossoverType _type = G_CROSSOVER_ERX;
+
+	template <typename TIdx>
+	static void cross(const TIdx *parent1, const TIdx *parent2, TIdx *child1, TIdx *child2, GCrossoverScratch<TIdx> &s, int vtxCount, GRandom &rng, const GDistanceOracle &) {
+		ERX_crossover(parent1, parent2, child1, s, parent1[0], vtxCount, rng);
+		if (child2)
+			ERX_crossover(parent1, parent2, child2, s, parent2[0], vtxCount, rng);
+	}
+};
+
+struct GCrossoverEAX {
+	static const GCrossoverType _type = G_CROSSOVER_EAX;
+
+	template <typename TIdx>
+	static void cross(const TIdx *parent1, const TIdx *parent2, TIdx *child1, TIdx *child2, GCrossoverScratch<TIdx> &s, int vtxCount, GRandom &rng, const GDistanceOracle &dist) {
+		EAX_crossover(parent1, parent2, child1, s, vtxCount, rng, dist);
+		if (child2)
+			EAX_crossover(parent2, parent1, child2, s, vtxCount, rng, dist);
+	}
+};
+
+
+
+#endif /*__CROSSOVER_H__*/
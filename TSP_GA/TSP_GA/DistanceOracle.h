@@ -0,0 +1,257 @@
+#ifndef __DISTANCEORACLE_H__
+#define __DISTANCEORACLE_H__
+
+
+
+#include <cstring>
+#include <cstdio>
+#include <atomic>
+
+#include "Graph.h"
+#include "TourLength.h"
+
+#define __DIST_DENSE_MAX_VTX__ 4096		// up to this cities count the whole distance matrix is precomputed
+#define __DIST_CACHE_BITS__ 20			// log2 of the entries count of the lazily filled distance cache
+#define __DIST_KEY_BITS__ 50			// bits of a city pair key, the slot index and a 30 bit tag, never all ones as the tag of an unused entry
+#define __DIST_CACHE_MAX_VTX__ (1 << 25)	// up to this cities count the pair keys are distinct, above it the distances are not cached
+#define __DIST_KEY_MIX__ 0x9E3779B97F5ULL	// odd multiplier to spread the pair keys over the cache
+#define __GEO_PI__ 3.141592				// value of pi used by TSPLIB for the GEO positions
+#define __GEO_RADIUS__ 6378.388			// earth radius of TSPLIB for the GEO distances
+#define __CHECK_DELTA_TOLERANCE__ 1e-3f	// relative error allowed between an incremental and a full length by the __CHECK_DELTA__ build
+
+
+// distance oracle of a set of cities, built once per city set and reading the positions from the vertex store,
+// small instances are answered from a dense float matrix, large instances from a bounded cache
+// filled on demand, so a tour length evaluation becomes a table lookup instead of sqrt calls
+//
+class GDistanceOracle {
+public:
+	GDistanceOracle() : _x(NULL), _y(NULL), _vtxCount(0), _metric(G_METRIC_EXACT), _matrix(NULL), _cache(NULL) {}
+	GDistanceOracle(const GVertexStore &vertices) : _x(NULL), _y(NULL), _vtxCount(0), _metric(G_METRIC_EXACT), _matrix(NULL), _cache(NULL) { build(vertices); }
+	~GDistanceOracle() { clear(); }
+
+	void build(const GVertexStore &vertices);		// (re)build the oracle for the given cities, which must outlive it
+	void clear();
+
+	int vtxCount() const { return _vtxCount; }
+	bool isDense() const { return _matrix != NULL; }
+
+	// distance between the cities of the given ids
+	//
+	float operator()(int i, int j) const {
+		if (_matrix)
+			return _matrix[i * _vtxCount + j];
+		return cachedDistance(i, j);
+	}
+
+	// distance between the cities of the given ids, computed from their coordinates by the metric of the cities
+	//
+	float distance(int i, int j) const {
+		if (_metric == G_METRIC_EXACT) {
+			float dx = _x[i] - _x[j];
+			float dy = _y[i] - _y[j];
+			return sqrtf(dx * dx + dy * dy);
+		}
+		return roundedDistance(i, j);
+	}
+
+	// length of a whole tour, the edge closing it included, by the vector kernel of the given level when there is one:
+	// the Euclidean distance is computed from the coordinates, the rounded metrics are read from the dense matrix,
+	// the rounded metrics of the cache mode are summed one edge at a time
+	//
+	template <typename TIdx>
+	float tourLength(const TIdx *tour, GSimdLevel level = __simdLevel) const {
+		if (_metric == G_METRIC_EXACT)
+			return coordTourLength(_x, _y, tour, _vtxCount, level);
+		if (_matrix)
+			return matrixTourLength(_matrix, tour, _vtxCount, level);
+		int last = _vtxCount - 1;
+		float length = cachedDistance(tour[last], tour[0]);
+		for (int i = 0; i < last; i++)
+			length += cachedDistance(tour[i], tour[i + 1]);
+		return length;
+	}
+
+private:
+	GDistanceOracle(const GDistanceOracle &);
+	GDistanceOracle &operator=(const GDistanceOracle &);
+
+	float cachedDistance(int i, int j) const;
+	float roundedDistance(int i, int j) const;
+	static double geoRadians(float v);
+
+	const float *_x;			// x positions of the cities, owned by the vertex store
+	const float *_y;			// y positions of the cities, owned by the vertex store
+	int _vtxCount;				// cities count
+	GMetric _metric;			// distance function of the cities
+	float *_matrix;				// dense distance matrix, NULL in cache mode
+	mutable std::atomic<unsigned long long> *_cache;	// cache entries, pair key tag in the high half and the distance bits in the low half,
+														// atomic so the worker threads of a solver may fill it concurrently
+};
+
+
+void GDistanceOracle::clear() {
+	delete[] _matrix;
+	delete[] _cache;
+	_x = _y = _matrix = NULL;
+	_cache = NULL;
+	_vtxCount = 0;
+	_metric = G_METRIC_EXACT;
+}
+
+void GDistanceOracle::build(const GVertexStore &vertices) {
+	clear();
+	_vtxCount = vertices._count;
+	_x = vertices._x;
+	_y = vertices._y;
+	_metric = vertices._metric;
+	// small instance, precompute the whole matrix
+	//
+	if (_vtxCount <= __DIST_DENSE_MAX_VTX__) {
+		_matrix = new float[_vtxCount * _vtxCount];
+		for (int i = 0; i < _vtxCount; i++) {
+			_matrix[i * _vtxCount + i] = 0.0f;
+			for (int j = i + 1; j < _vtxCount; j++)
+				_matrix[i * _vtxCount + j] = _matrix[j * _vtxCount + i] = distance(i, j);
+		}
+	}
+	// large instance, an empty cache, every entry is tagged as unused,
+	// no cache above __DIST_CACHE_MAX_VTX__ cities, whose pairs would share keys
+	//
+	else if (_vtxCount <= __DIST_CACHE_MAX_VTX__) {
+		_cache = new std::atomic<unsigned long long>[1 << __DIST_CACHE_BITS__];
+		for (int i = 0; i < (1 << __DIST_CACHE_BITS__); i++)
+			_cache[i].store(~0ULL, std::memory_order_relaxed);
+	}
+}
+
+// look the distance up in the cache, compute and store it on a miss,
+// the mixed pair key is split in the slot index and the tag, so a hit is always exact
+//
+float GDistanceOracle::cachedDistance(int i, int j) const {
+	if (!_cache)
+		return distance(i, j);
+	if (i > j) {
+		int t = i; i = j; j = t;
+	}
+	unsigned long long key = ((unsigned long long)i * _vtxCount + j) * __DIST_KEY_MIX__ & ((1ULL << __DIST_KEY_BITS__) - 1);
+	std::atomic<unsigned long long> &slot = _cache[key & ((1 << __DIST_CACHE_BITS__) - 1)];
+	unsigned long long entry = slot.load(std::memory_order_relaxed);
+	unsigned tag = (unsigned)(key >> __DIST_CACHE_BITS__);
+	float d;
+	if ((unsigned)(entry >> 32) == tag) {
+		unsigned bits = (unsigned)entry;
+		memcpy(&d, &bits, sizeof(float));
+		return d;
+	}
+	d = distance(i, j);
+	unsigned bits;
+	memcpy(&bits, &d, sizeof(float));
+	slot.store(((unsigned long long)tag << 32) | bits, std::memory_order_relaxed);
+	return d;
+}
+
+// latitude or longitude in radians of a TSPLIB GEO position, given in DDD.MM format
+//
+double GDistanceOracle::geoRadians(float v) {
+	int deg = (int)v;
+	double min = v - deg;
+	return __GEO_PI__ * (deg + 5.0 * min / 3.0) / 180.0;
+}
+
+// distance of the TSPLIB edge weight types, computed in double and rounded to an integer as TSPLIB defines it
+//
+float GDistanceOracle::roundedDistance(int i, int j) const {
+	double dx = (double)_x[i] - _x[j];
+	double dy = (double)_y[i] - _y[j];
+	switch (_metric) {
+	case G_METRIC_EUC_2D:
+		return (float)(int)(sqrt(dx * dx + dy * dy) + 0.5);
+	case G_METRIC_CEIL_2D:
+		return (float)ceil(sqrt(dx * dx + dy * dy));
+	case G_METRIC_GEO: {
+		double q1 = cos(geoRadians(_y[i]) - geoRadians(_y[j]));
+		double q2 = cos(geoRadians(_x[i]) - geoRadians(_x[j]));
+		double q3 = cos(geoRadians(_x[i]) + geoRadians(_x[j]));
+		return (float)(int)(__GEO_RADIUS__ * acos(0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3)) + 1.0);
+	}
+	case G_METRIC_ATT: {
+		double r = sqrt((dx * dx + dy * dy) / 10.0);
+		int t = (int)(r + 0.5);
+		return (float)(t < r ? t + 1 : t);
+	}
+	default:
+		return (float)sqrt(dx * dx + dy * dy);
+	}
+}
+
+
+
+// update the length of this path, tour indeed, by the tour length kernel of the distance oracle
+//
+template <typename TIdx>
+void GPath<TIdx>::updateLength(const GDistanceOracle &dist) {
+	if (_path)
+		_length = dist.tourLength(_path);
+}
+
+
+// length change of swapping the cities at the positions i and j, only the edges around the two positions change,
+// so the change is computed from at most 8 distances whatever the length of the tour
+//
+template <typename TIdx>
+float GPath<TIdx>::swapDelta(const GDistanceOracle &dist, int i, int j) const {
+	int n = dist.vtxCount();
+	// a swap reverses a tour of up to 3 cities, which keeps its length
+	//
+	if (i == j || n <= 3)
+		return 0.0f;
+	// order the positions so that j follows i when they are adjacent, the last and the first positions are adjacent too
+	//
+	if ((j + 1) % n == i) {
+		int t = i; i = j; j = t;
+	}
+	int a = _path[i], b = _path[j];
+	int pi = _path[i == 0 ? n - 1 : i - 1];
+	int nj = _path[j == n - 1 ? 0 : j + 1];
+	// adjacent cities, the edges pi-a, a-b and b-nj become pi-b, b-a and a-nj
+	//
+	if ((i + 1) % n == j)
+		return dist(pi, b) + dist(a, nj) - dist(pi, a) - dist(b, nj);
+	int ni = _path[i == n - 1 ? 0 : i + 1];
+	int pj = _path[j == 0 ? n - 1 : j - 1];
+	return dist(pi, b) + dist(b, ni) + dist(pj, a) + dist(a, nj)
+		- dist(pi, a) - dist(a, ni) - dist(pj, b) - dist(b, nj);
+}
+
+template <typename TIdx>
+void GPath<TIdx>::swapCities(const GDistanceOracle &dist, int i, int j) {
+	_length += swapDelta(dist, i, j);
+	TIdx vtx = _path[i];
+	_path[i] = _path[j];
+	_path[j] = vtx;
+	checkLength(dist, "swap");
+}
+
+// debug check of the incremental length updates, the build defining __CHECK_DELTA__ recomputes the whole length
+// after every incremental update and stops on a mismatch, other builds do nothing
+//
+template <typename TIdx>
+void GPath<TIdx>::checkLength(const GDistanceOracle &dist, const char *move) const {
+#ifdef __CHECK_DELTA__
+	GPath<TIdx> full;
+	full._path = _path;
+	full.updateLength(dist);
+	if (fabs(full._length - _length) > __CHECK_DELTA_TOLERANCE__ * (full._length > 1.0f ? full._length : 1.0f)) {
+		fprintf(stderr, "%s: incremental length %f, full length %f\n", move, _length, full._length);
+		abort();
+	}
+#else
+	(void)dist;
+	(void)move;
+#endif
+}
+
+
+
+#endif /*__DISTANCEORACLE_H__*/
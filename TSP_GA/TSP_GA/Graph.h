@@ -6,46 +6,95 @@
 
 
 #include <iostream>
+#include <cmath>
+#include <cstdlib>
 using namespace std;
 
-typedef short int S_INT;
+#include "Random.h"
 
-extern int __gVtxCount;
+#define __IDX8_MAX_VTX__ 255		// up to this cities count tours are stored as 8 bit city indices
+#define __IDX16_MAX_VTX__ 65535		// up to this cities count tours are stored as 16 bit city indices
 
-// class of vertices
+
+// distance function between two cities, the TSPLIB edge weight types round the distances to integers
+//
+enum GMetric {
+	G_METRIC_EXACT,			// euclidean distance, not rounded, used for the random cities
+	G_METRIC_EUC_2D,		// euclidean distance rounded to the nearest integer
+	G_METRIC_CEIL_2D,		// euclidean distance rounded up
+	G_METRIC_GEO,			// geographical distance, positions are latitude and longitude in DDD.MM format
+	G_METRIC_ATT			// pseudo euclidean distance
+};
+
+
+// store of the cities, positions are kept as structure of arrays indexed by city id,
+// so they live once and tours only refer to them by index
 //
-class GEdgeVertex {
+class GVertexStore {
 public:
-	GEdgeVertex() : _vid(-1) {};
-	GEdgeVertex(int vid, int x, int y) : _vid(vid), _x(x), _y(y) {};
-	S_INT _vid;				// vertex Id
-	S_INT _x;				// x position
-	S_INT _y;				// y position
-}*__GVerices = NULL;	// array of verices, cities
+	GVertexStore() : _x(NULL), _y(NULL), _count(0), _metric(G_METRIC_EXACT) {}
+	~GVertexStore() { clear(); }
+	float *_x;				// x positions
+	float *_y;				// y positions
+	int _count;				// cities count
+	GMetric _metric;		// distance function between the cities
 
+	void resize(int count);		// method to drop the current cities and make room for count cities
+	void clear();
 
+private:
+	GVertexStore(const GVertexStore &);
+	GVertexStore &operator=(const GVertexStore &);
+};
 
-// class of graph path 
+void GVertexStore::resize(int count) {
+	clear();
+	_count = count;
+	_x = new float[_count];
+	_y = new float[_count];
+}
+
+void GVertexStore::clear() {
+	delete[] _x;
+	delete[] _y;
+	_x = _y = NULL;
+	_count = 0;
+	_metric = G_METRIC_EXACT;
+}
+
+
+
+class GDistanceOracle;
+
+// class of graph path, the tour is a permutation of city indices,
+// TIdx is the narrowest unsigned type able to hold all city ids of the instance
 //
+template <typename TIdx>
 class GPath {
 public:
-	GPath() : _path(NULL), _length(0.0) {}
-	GEdgeVertex *_path;			// tha path, vertices array, associated to this graph path
+	GPath() : _path(NULL), _length(0.0), _hash(0) {}
+	TIdx *_path;				// tha path, city indices array, associated to this graph path
 	float _length;				// length of the path
+	unsigned long long _hash;	// GTourHash of the tour, only kept by the solvers rejecting duplicate tours
+
+	void updateLength(const GDistanceOracle &dist);		// method to update the length of this path, defined in DistanceOracle.h
+	float swapDelta(const GDistanceOracle &dist, int i, int j) const;		// length change of swapping the cities at the positions i and j
+	void swapCities(const GDistanceOracle &dist, int i, int j);			// swap the cities at the positions i and j, updating the length in O(1)
+	void checkLength(const GDistanceOracle &dist, const char *move) const;	// compare the length with a full recompute, with __CHECK_DELTA__ only
+};
+
 
-	void updateLength();		// method to update the length of this path
-} **__toursPopulationList = NULL, *__bestTour = NULL;	// population list array, and best tour
 
-// update the length of this path, tour indeed
+// function to place the given count of vertices randomly inside a w x h area
 //
-void GPath::updateLength() {
-	if (_path) {
-		_length = 0.0;
-		for (int i = 0; i < __gVtxCount; i++)
-			_length += (float)sqrt(pow(_path[i]._x - _path[(i + 1) % __gVtxCount]._x, 2) + pow(_path[i]._y - _path[(i + 1) % __gVtxCount]._y, 2));
+void randomVertices(GVertexStore &vertices, int vtxCount, int w, int h, GRandom &rng) {
+	vertices.resize(vtxCount);
+	for (int i = 0; i < vtxCount; i++) {
+		vertices._x[i] = (float)rng.below(w);
+		vertices._y[i] = (float)rng.below(h);
 	}
 }
 
 
 
-#endif /*__GRAPH_H__*/
\ No newline at end of file
+#endif /*__GRAPH_H__*/
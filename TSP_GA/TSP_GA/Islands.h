@@ -0,0 +1,152 @@
+#ifndef __ISLANDS_H__
+#define __ISLANDS_H__
+
+
+
+#include <atomic>
+#include <cstring>
+
+#include "Graph.h"
+#include "Random.h"
+
+
+// migration topology of the island model
+//
+enum TSPMigration {
+	TSP_MIGRATE_RING,		// island i sends its migrants to island i+1
+	TSP_MIGRATE_RANDOM		// every migration picks a random other island
+};
+
+
+// packet of migrant tours, the genes of all migrants live in one buffer
+//
+template <typename TIdx>
+struct GMigrants {
+	GMigrants() : _count(0), _lengths(NULL), _genes(NULL) {}
+	~GMigrants() { delete[] _lengths; delete[] _genes; }
+	int _count;					// migrants count in the packet
+	float *_lengths;			// tour lengths of the migrants
+	TIdx *_genes;				// tours of the migrants, one after the other
+};
+
+
+// state shared by all islands, a mailbox per island and the pool of migrant packets.
+// a mailbox holds at most one packet, senders and receivers hand packets over by atomic exchange only,
+// so no island ever waits for another one
+//
+template <typename TIdx>
+class TSPArchipelago {
+public:
+	TSPArchipelago(int islandCount, int migrantCount, int vtxCount, TSPMigration topology);
+	~TSPArchipelago();
+
+	int islandCount() const { return _islandCount; }
+	int migrantCount() const { return _migrantCount; }
+	int vtxCount() const { return _vtxCount; }
+	TSPMigration topology() const { return _topology; }
+	std::atomic<GMigrants<TIdx> *> &mailbox(int island) { return _mailboxes[island]; }
+	GMigrants<TIdx> *packet(int i) { return &_packets[i]; }
+	int packetCount() const { return 2 * _islandCount; }
+
+private:
+	TSPArchipelago(const TSPArchipelago &);
+	TSPArchipelago &operator=(const TSPArchipelago &);
+
+	int _islandCount;						// islands count
+	int _migrantCount;						// tours sent in every migration
+	int _vtxCount;							// cities count
+	TSPMigration _topology;					// migration topology
+	std::atomic<GMigrants<TIdx> *> *_mailboxes;		// incoming packet of every island, NULL if empty
+	GMigrants<TIdx> *_packets;				// all packets, two per island
+};
+
+
+template <typename TIdx>
+TSPArchipelago<TIdx>::TSPArchipelago(int islandCount, int migrantCount, int vtxCount, TSPMigration topology)
+	: _islandCount(islandCount), _migrantCount(migrantCount), _vtxCount(vtxCount), _topology(topology) {
+	_mailboxes = new std::atomic<GMigrants<TIdx> *>[_islandCount];
+	for (int i = 0; i < _islandCount; i++)
+		_mailboxes[i].store(NULL);
+	_packets = new GMigrants<TIdx>[packetCount()];
+	for (int i = 0; i < packetCount(); i++) {
+		_packets[i]._lengths = new float[_migrantCount];
+		_packets[i]._genes = new TIdx[_migrantCount * _vtxCount];
+	}
+}
+
+template <typename TIdx>
+TSPArchipelago<TIdx>::~TSPArchipelago() {
+	delete[] _mailboxes;
+	delete[] _packets;
+}
+
+
+
+// link of one island to the archipelago, owned by the island thread,
+// keeps the packets the island currently owns
+//
+template <typename TIdx>
+class TSPIslandLink {
+public:
+	TSPIslandLink() : _archipelago(NULL), _island(0), _free(NULL), _freeCount(0) {}
+	~TSPIslandLink() { delete[] _free; }
+
+	void attach(TSPArchipelago<TIdx> *archipelago, int island);
+
+	// packet to fill with the outgoing migrants, NULL if the island owns no free packet right now
+	//
+	GMigrants<TIdx> *outgoing() { return _freeCount ? _free[--_freeCount] : NULL; }
+	void send(GMigrants<TIdx> *packet, GRandom &rng);		// post the filled packet to the neighbour island
+	GMigrants<TIdx> *receive();								// take the incoming packet, NULL if there is none
+	void release(GMigrants<TIdx> *packet) { _free[_freeCount++] = packet; }		// give a consumed packet back to the island
+
+	int migrantCount() const { return _archipelago->migrantCount(); }
+	int index() const { return _island; }
+
+private:
+	TSPIslandLink(const TSPIslandLink &);
+	TSPIslandLink &operator=(const TSPIslandLink &);
+
+	TSPArchipelago<TIdx> *_archipelago;
+	int _island;						// index of this island
+	GMigrants<TIdx> **_free;			// packets owned by this island
+	int _freeCount;
+};
+
+
+template <typename TIdx>
+void TSPIslandLink<TIdx>::attach(TSPArchipelago<TIdx> *archipelago, int island) {
+	_archipelago = archipelago;
+	_island = island;
+	delete[] _free;
+	_free = new GMigrants<TIdx> *[_archipelago->packetCount()];
+	_free[0] = _archipelago->packet(2 * island);
+	_free[1] = _archipelago->packet(2 * island + 1);
+	_freeCount = 2;
+}
+
+// the packet is swapped into the mailbox of the target island,
+// an older packet the target did not consume yet is taken back, its migrants are simply outdated
+//
+template <typename TIdx>
+void TSPIslandLink<TIdx>::send(GMigrants<TIdx> *packet, GRandom &rng) {
+	int count = _archipelago->islandCount();
+	int target = (_island + 1) % count;
+	if (_archipelago->topology() == TSP_MIGRATE_RANDOM) {
+		target = rng.below(count - 1);
+		if (target >= _island)
+			target++;
+	}
+	GMigrants<TIdx> *old = _archipelago->mailbox(target).exchange(packet, std::memory_order_acq_rel);
+	if (old)
+		release(old);
+}
+
+template <typename TIdx>
+GMigrants<TIdx> *TSPIslandLink<TIdx>::receive() {
+	return _archipelago->mailbox(_island).exchange(NULL, std::memory_order_acq_rel);
+}
+
+
+
+#endif /*__ISLANDS_H__*/
@@ -0,0 +1,270 @@
+#ifndef __LOCALSEARCH_H__
+#define __LOCALSEARCH_H__
+
+
+
+#include <cstring>
+
+#include "DistanceOracle.h"
+
+#define __LS_MIN_VTX__ 8			// smaller tours are not improved, the moves need distinct edges
+#define __LS_MAX_SEGMENT__ 3		// longest segment moved by Or-opt
+#define __LS_EPSILON__ 1e-4f		// smallest gain accepted as an improvement, so rounding never loops
+
+
+// local search improving a tour by 2-opt and Or-opt moves until no move gains anything,
+// every move is evaluated by its edge delta in O(1), don't look bits keep the search on the cities around the last changes.
+// the candidate cities of a move are the neighbour lists given to candidates(), or every city if there are none.
+// a local search is owned by one thread, it keeps its scratch buffers between the calls
+//
+template <typename TIdx>
+class GLocalSearch {
+public:
+	GLocalSearch() : _pos(NULL), _active(NULL), _queue(NULL), _vtxCount(0), _head(0), _tail(0), _queued(0), _neighbours(NULL), _neighbourCount(0) {}
+	~GLocalSearch() { clear(); }
+
+	void allocate(int vtxCount);
+	void clear();
+
+	// use the given lists of neighbourCount neighbours of every city, nearest first, as move candidates
+	//
+	void candidates(const int *neighbours, int neighbourCount) { _neighbours = neighbours; _neighbourCount = neighbourCount; }
+
+	// improve the given tour until it is 2-opt and Or-opt optimal, return true if it was improved
+	//
+	bool optimize(GPath<TIdx> *tour, const GDistanceOracle &dist);
+
+private:
+	GLocalSearch(const GLocalSearch &);
+	GLocalSearch &operator=(const GLocalSearch &);
+
+	int succ(int c) const { int i = _pos[c] + 1; return _tour[i == _vtxCount ? 0 : i]; }
+	int pred(int c) const { int i = _pos[c]; return _tour[i == 0 ? _vtxCount - 1 : i - 1]; }
+	int candidateCount() const { return _neighbours ? _neighbourCount : _vtxCount; }
+	int candidate(int c, int k) const { return _neighbours ? _neighbours[c * _neighbourCount + k] : k; }
+
+	void activate(int c);
+	void reverse(int from, int len);
+	void reverseShorter(int from, int to);
+	bool twoOptMove(int a, const GDistanceOracle &dist);
+	bool orOptMove(int a, const GDistanceOracle &dist);
+
+	TIdx *_tour;				// tour under improvement
+	int *_pos;					// position of every city in the tour
+	char *_active;				// don't look bits, inverted, set for the cities in the queue
+	int *_queue;				// circular queue of the cities to look at
+	int _vtxCount;				// cities count
+	int _head, _tail;			// queue bounds
+	int _queued;				// cities count in the queue
+	double _delta;			// length change of the moves applied so far
+	const int *_neighbours;		// neighbour lists of the cities, NULL to try every city
+	int _neighbourCount;		// neighbours count of every list
+};
+
+
+template <typename TIdx>
+void GLocalSearch<TIdx>::allocate(int vtxCount) {
+	clear();
+	_vtxCount = vtxCount;
+	_pos = new int[_vtxCount];
+	_active = new char[_vtxCount];
+	_queue = new int[_vtxCount];
+}
+
+template <typename TIdx>
+void GLocalSearch<TIdx>::clear() {
+	delete[] _pos;
+	delete[] _active;
+	delete[] _queue;
+	_pos = _queue = NULL;
+	_active = NULL;
+	_vtxCount = 0;
+}
+
+// clear the don't look bit of the city and queue it, if it is not already queued
+//
+template <typename TIdx>
+void GLocalSearch<TIdx>::activate(int c) {
+	if (!_active[c]) {
+		_active[c] = 1;
+		_queue[_tail] = c;
+		_tail = _tail + 1 == _vtxCount ? 0 : _tail + 1;
+		_queued++;
+	}
+}
+
+// reverse len cities of the tour from the position from, cyclically
+//
+template <typename TIdx>
+void GLocalSearch<TIdx>::reverse(int from, int len) {
+	int i = from, j = from + len - 1;
+	if (j >= _vtxCount)
+		j -= _vtxCount;
+	for (int k = 0; k < len / 2; k++) {
+		TIdx t = _tour[i];
+		_tour[i] = _tour[j];
+		_tour[j] = t;
+		_pos[_tour[i]] = i;
+		_pos[_tour[j]] = j;
+		if (++i == _vtxCount) i = 0;
+		if (--j < 0) j = _vtxCount - 1;
+	}
+}
+
+// reverse the tour between the positions from and to, cyclically,
+// the rest of the tour is reversed instead when it is shorter, which gives the same cyclic tour
+//
+template <typename TIdx>
+void GLocalSearch<TIdx>::reverseShorter(int from, int to) {
+	int len = to - from + 1;
+	if (len <= 0)
+		len += _vtxCount;
+	if (2 * len > _vtxCount)
+		reverse(to + 1 == _vtxCount ? 0 : to + 1, _vtxCount - len);
+	else
+		reverse(from, len);
+}
+
+// look for an improving 2-opt move removing one of the two tour edges of the city a,
+// the edges (a, b) and (c, d) are replaced by (a, c) and (b, d), the first improving move is applied
+//
+template <typename TIdx>
+bool GLocalSearch<TIdx>::twoOptMove(int a, const GDistanceOracle &dist) {
+	for (int dir = 0; dir < 2; dir++) {
+		int b = dir ? pred(a) : succ(a);
+		float ab = dist(a, b);
+		for (int k = 0; k < candidateCount(); k++) {
+			int c = candidate(a, k);
+			float ac = dist(a, c);
+			// the new edge (a, c) must be shorter than (a, b), with nearest first lists no later candidate can be
+			//
+			if (ac >= ab) {
+				if (_neighbours)
+					break;
+				continue;
+			}
+			int d = dir ? pred(c) : succ(c);
+			if (c == a || c == b || d == a)
+				continue;
+			float delta = ac + dist(b, d) - ab - dist(c, d);
+			if (delta < -__LS_EPSILON__) {
+				if (dir)
+					reverseShorter(_pos[c], _pos[b]);
+				else
+					reverseShorter(_pos[b], _pos[c]);
+				_delta += delta;
+				activate(a); activate(b); activate(c); activate(d);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// look for an improving Or-opt move of the segment of 1 to 3 cities starting at the city a,
+// the segment is moved, reversed or not, between a candidate city c and its successor e,
+// the first improving move is applied
+//
+template <typename TIdx>
+bool GLocalSearch<TIdx>::orOptMove(int a, const GDistanceOracle &dist) {
+	int i = _pos[a];
+	for (int len = 1; len <= __LS_MAX_SEGMENT__; len++) {
+		int s1 = a;
+		int s2 = _tour[(i + len - 1) % _vtxCount];
+		int p = pred(s1);
+		int nx = succ(s2);
+		float removed = dist(p, s1) + dist(s2, nx) - dist(p, nx);
+		if (removed <= __LS_EPSILON__)
+			continue;
+		// the segment is inserted next to a candidate of either end of the segment
+		//
+		for (int end = 0; end < 2; end++) {
+			int s = end ? s2 : s1;
+			for (int k = 0; k < candidateCount(); k++) {
+				int c = candidate(s, k);
+				float sc = dist(s, c);
+				if (sc >= removed) {
+					if (_neighbours)
+						break;
+					continue;
+				}
+				// try both edges of c, (c, succ c) and (pred c, c)
+				//
+				for (int side = 0; side < 2; side++) {
+					int from = side ? pred(c) : c;
+					int to = side ? c : succ(c);
+					if ((_pos[from] - i + _vtxCount) % _vtxCount < len || (_pos[to] - i + _vtxCount) % _vtxCount < len)
+						continue;
+					float forward = dist(from, s1) + dist(s2, to);
+					float backward = dist(from, s2) + dist(s1, to);
+					bool reversed = backward < forward;
+					float delta = (reversed ? backward : forward) - dist(from, to) - removed;
+					if (delta >= -__LS_EPSILON__)
+						continue;
+					// the segment S and the block B between it and the insertion edge are swapped by reversals,
+					// going the shorter way round the tour
+					//
+					int after = (_pos[from] - (i + len) + 2 * _vtxCount) % _vtxCount + 1;
+					int before = (i - 1 - _pos[to] + 2 * _vtxCount) % _vtxCount + 1;
+					if (after <= before) {
+						// S B -> B S'
+						//
+						reverse(i, len + after);
+						reverse(i, after);
+						if (!reversed)
+							reverse((i + after) % _vtxCount, len);
+					}
+					else {
+						// B S -> S' B
+						//
+						int start = _pos[to];
+						reverse(start, before + len);
+						reverse((start + len) % _vtxCount, before);
+						if (!reversed)
+							reverse(start, len);
+					}
+					_delta += delta;
+					activate(p); activate(nx); activate(s1); activate(s2); activate(from); activate(to);
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+template <typename TIdx>
+bool GLocalSearch<TIdx>::optimize(GPath<TIdx> *tour, const GDistanceOracle &dist) {
+	if (_vtxCount < __LS_MIN_VTX__)
+		return false;
+	_tour = tour->_path;
+	_delta = 0.0;
+	// every city starts in the queue
+	//
+	for (int i = 0; i < _vtxCount; i++) {
+		_pos[_tour[i]] = i;
+		_active[i] = 1;
+		_queue[i] = _tour[i];
+	}
+	_head = _tail = 0;
+	_queued = _vtxCount;
+	// look at the queued cities until no move improves the tour, a city is dropped, its don't look bit set,
+	// when none of its moves improves, and queued again when a move changes one of its edges
+	//
+	while (_queued) {
+		int a = _queue[_head];
+		_head = _head + 1 == _vtxCount ? 0 : _head + 1;
+		_queued--;
+		_active[a] = 0;
+		while (twoOptMove(a, dist) || orOptMove(a, dist));
+	}
+	// the length is updated by the deltas of the applied moves, no full evaluation
+	//
+	tour->_length = (float)(tour->_length + _delta);
+	tour->checkLength(dist, "local search");
+	return _delta < 0.0;
+}
+
+
+
+#endif /*__LOCALSEARCH_H__*/
@@ -0,0 +1,192 @@
+#ifndef __POPULATION_H__
+#define __POPULATION_H__
+
+
+
+#include <cstring>
+
+#include "Graph.h"
+
+#define __CACHE_LINE__ 64		// tours are laid out on cache line boundaries
+
+
+// population arena, the tours of the population and the child slots live in one contiguous slab,
+// allocated once per solve, so the generation loop never touches the heap.
+// a child is made in a spare slot and swapped into the population in place of a looser,
+// the storage of the looser becomes the spare slot for the next child.
+// the packed arena keeps the population tours as bit streams of ceil(log2 cities) bits per city instead,
+// their headers have no path, a tour is read by genes() or read() and written by write(), a child is packed
+// into the storage of the looser it replaces, only the child slots are plain arrays
+//
+template <typename TIdx>
+class GPopulation {
+public:
+	GPopulation() : _slab(NULL), _paths(NULL), _tours(NULL), _scratch(NULL), _spares(NULL), _packed(NULL), _count(0), _spareCount(0), _stride(0),
+		_vtxCount(0), _bits(0), _words(0) {}
+	~GPopulation() { clear(); }
+
+	void allocate(int count, int spareCount, int vtxCount, bool packed = false);		// allocate count tours and spareCount child slots
+	void clear();
+
+	int count() const { return _count; }
+	bool packed() const { return _packed != NULL; }
+	size_t bytes() const { return _packed ? _count * _words * sizeof(unsigned long long) : _count * _stride; }	// bytes of the population genes
+	GPath<TIdx> **tours() { return _tours; }				// population list, in rank order once sorted
+	GPath<TIdx> *&operator[](int i) { return _tours[i]; }
+	GPath<TIdx> **scratch() { return _scratch; }			// scratch list of count entries, for sorting and partitioning
+	GPath<TIdx> *spare(int s) { return _spares[s]; }
+
+	// swap the child in the spare slot s into the population position i, or pack it into the tour at i
+	//
+	void replace(int i, int s) {
+		GPath<TIdx> *tour = _tours[i];
+		if (_packed) {
+			pack(words(tour), _spares[s]->_path);
+			tour->_length = _spares[s]->_length;
+			tour->_hash = _spares[s]->_hash;
+			return;
+		}
+		_tours[i] = _spares[s];
+		_spares[s] = tour;
+	}
+
+	// genes of the given tour of the population, its path, or the given buffer it is unpacked to
+	//
+	const TIdx *genes(const GPath<TIdx> *tour, TIdx *buffer) const {
+		if (!_packed)
+			return tour->_path;
+		unpack(words(tour), buffer);
+		return buffer;
+	}
+
+	// copy the genes of the given tour of the population out, or into it
+	//
+	void read(const GPath<TIdx> *tour, TIdx *genes) const {
+		if (_packed)
+			unpack(words(tour), genes);
+		else
+			memcpy(genes, tour->_path, _vtxCount * sizeof(TIdx));
+	}
+	void write(GPath<TIdx> *tour, const TIdx *genes) {
+		if (_packed)
+			pack(words(tour), genes);
+		else
+			memcpy(tour->_path, genes, _vtxCount * sizeof(TIdx));
+	}
+
+private:
+	GPopulation(const GPopulation &);
+	GPopulation &operator=(const GPopulation &);
+
+	unsigned long long *words(const GPath<TIdx> *tour) const { return _packed + (tour - _paths) * _words; }
+	void pack(unsigned long long *words, const TIdx *genes) const;
+	void unpack(const unsigned long long *words, TIdx *genes) const;
+
+	char *_slab;					// genes of all tours, each tour starting on a cache line
+	GPath<TIdx> *_paths;			// tour headers, one per slot
+	GPath<TIdx> **_tours;			// population list array
+	GPath<TIdx> **_scratch;			// scratch list array
+	GPath<TIdx> **_spares;			// child slots
+	unsigned long long *_packed;	// packed genes of the population tours, NULL if they are in the slab
+	int _count;						// population count
+	int _spareCount;				// child slots count
+	size_t _stride;					// bytes between two tours of the slab
+	int _vtxCount;					// cities count of a tour
+	int _bits;						// bits of a packed city id
+	size_t _words;					// 64 bit words of a packed tour
+};
+
+
+template <typename TIdx>
+void GPopulation<TIdx>::allocate(int count, int spareCount, int vtxCount, bool packed) {
+	clear();
+	_count = count;
+	_spareCount = spareCount;
+	_vtxCount = vtxCount;
+	_stride = (vtxCount * sizeof(TIdx) + __CACHE_LINE__ - 1) / __CACHE_LINE__ * __CACHE_LINE__;
+	// the packed tours are bit streams in 64 bit words, the slab only holds the child slots
+	//
+	int plain = _count;
+	if (packed) {
+		_bits = 1;
+		while ((1LL << _bits) < vtxCount)
+			_bits++;
+		_words = ((size_t)vtxCount * _bits + 63) / 64;
+		_packed = new unsigned long long[_count * _words];
+		plain = 0;
+	}
+	int slots = _count + _spareCount;
+	_slab = new char[(plain + _spareCount) * _stride + __CACHE_LINE__];
+	char *genes = (char *)(((size_t)_slab + __CACHE_LINE__ - 1) & ~(size_t)(__CACHE_LINE__ - 1));
+	_paths = new GPath<TIdx>[slots];
+	_tours = new GPath<TIdx> *[_count];
+	_scratch = new GPath<TIdx> *[_count];
+	_spares = new GPath<TIdx> *[_spareCount];
+	for (int i = 0; i < slots; i++) {
+		if (i < _count)
+			_tours[i] = &_paths[i];
+		else
+			_spares[i - _count] = &_paths[i];
+		if (i >= _count - plain)
+			_paths[i]._path = (TIdx *)(genes + (i - (_count - plain)) * _stride);
+	}
+}
+
+template <typename TIdx>
+void GPopulation<TIdx>::clear() {
+	delete[] _slab;
+	delete[] _paths;
+	delete[] _tours;
+	delete[] _scratch;
+	delete[] _spares;
+	delete[] _packed;
+	_slab = NULL;
+	_paths = NULL;
+	_tours = _scratch = _spares = NULL;
+	_packed = NULL;
+	_count = _spareCount = 0;
+}
+
+// pack the city ids into the words, the bits of an id go from the low bits of a word up, an id may span two words
+//
+template <typename TIdx>
+void GPopulation<TIdx>::pack(unsigned long long *words, const TIdx *genes) const {
+	unsigned long long acc = 0;
+	int fill = 0;
+	for (int i = 0; i < _vtxCount; i++) {
+		unsigned long long v = genes[i];
+		acc |= v << fill;
+		fill += _bits;
+		if (fill >= 64) {
+			*words++ = acc;
+			fill -= 64;
+			acc = fill ? v >> (_bits - fill) : 0;
+		}
+	}
+	if (fill)
+		*words = acc;
+}
+
+template <typename TIdx>
+void GPopulation<TIdx>::unpack(const unsigned long long *words, TIdx *genes) const {
+	unsigned long long mask = (1ULL << _bits) - 1;
+	unsigned long long acc = *words++;
+	int avail = 64;
+	for (int i = 0; i < _vtxCount; i++) {
+		if (avail >= _bits) {
+			genes[i] = (TIdx)(acc & mask);
+			acc >>= _bits;
+			avail -= _bits;
+		}
+		else {
+			unsigned long long next = *words++;
+			genes[i] = (TIdx)((acc | next << avail) & mask);
+			acc = next >> (_bits - avail);
+			avail += 64 - _bits;
+		}
+	}
+}
+
+
+
+#endif /*__POPULATION_H__*/
@@ -0,0 +1,164 @@
+#ifndef __RANDOM_H__
+#define __RANDOM_H__
+
+
+
+#include <ctime>
+#include <cstddef>
+
+
+// fast seedable random engine, xoshiro128** seeded through splitmix64,
+// it has no global state, so every thread owns its own engine instead of sharing rand()
+//
+class GRandom {
+public:
+	GRandom() { seed(0); }
+	explicit GRandom(unsigned long long s) { seed(s); }
+
+	// seed the engine, 0 seeds from the clock
+	//
+	void seed(unsigned long long s) {
+		if (!s)
+			s = ((unsigned long long)time(NULL) << 20) ^ (unsigned long long)clock() ^ (unsigned long long)(size_t)this;
+		for (int i = 0; i < 4; i++) {
+			s += 0x9E3779B97F4A7C15ULL;
+			unsigned long long z = s;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			_s[i] = (unsigned)(z ^ (z >> 31));
+		}
+	}
+
+	// copy the engine state out or in, so a run can be checkpointed and resumed with the same random sequence
+	//
+	void getState(unsigned s[4]) const { for (int i = 0; i < 4; i++) s[i] = _s[i]; }
+	void setState(const unsigned s[4]) { for (int i = 0; i < 4; i++) _s[i] = s[i]; }
+
+	// next 32 random bits
+	//
+	unsigned next() {
+		unsigned r = rotl(_s[1] * 5, 7) * 9;
+		unsigned t = _s[1] << 9;
+		_s[2] ^= _s[0];
+		_s[3] ^= _s[1];
+		_s[1] ^= _s[2];
+		_s[0] ^= _s[3];
+		_s[2] ^= t;
+		_s[3] = rotl(_s[3], 11);
+		return r;
+	}
+
+	// random integer in [0, n), by multiply and shift instead of modulo
+	//
+	int below(int n) { return (int)(((unsigned long long)next() * (unsigned)n) >> 32); }
+
+	// random float in [0.0, 1.0)
+	//
+	float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }
+
+	// shuffle the given array in place, Fisher-Yates
+	//
+	template <typename T>
+	void shuffle(T *a, int n) {
+		for (int i = n - 1; i > 0; i--) {
+			int j = below(i + 1);
+			T t = a[i]; a[i] = a[j]; a[j] = t;
+		}
+	}
+
+private:
+	static unsigned rotl(unsigned x, int k) { return (x << k) | (x >> (32 - k)); }
+
+	unsigned _s[4];			// engine state
+};
+
+
+
+// alias table drawing an index with a probability proportional to its weight in O(1), Vose's method,
+// every index owns a slot keeping it with its probability and sending the rest of the slot to an alias index.
+// built in O(n), then read only, so the threads draw from one table with their own engines
+//
+class GAliasTable {
+public:
+	GAliasTable() : _prob(NULL), _alias(NULL), _stack(NULL), _count(0), _capacity(0) {}
+	~GAliasTable() { clear(); }
+
+	void build(const float *weights, int count);		// weights of the indices 0 to count - 1, not all 0, none negative
+	void clear();
+
+	int count() const { return _count; }
+
+	// draw an index, one slot picked uniformly then the index or its alias
+	//
+	int draw(GRandom &rng) const {
+		int i = rng.below(_count);
+		return rng.uniform() < _prob[i] ? i : _alias[i];
+	}
+
+private:
+	GAliasTable(const GAliasTable &);
+	GAliasTable &operator=(const GAliasTable &);
+
+	float *_prob;			// probability of every slot to keep its own index
+	int *_alias;			// index the rest of every slot goes to
+	int *_stack;			// work lists of the build, the slots under 1 from the front and the others from the back
+	int _count;				// indices count
+	int _capacity;			// indices count of the buffers
+};
+
+
+void GAliasTable::build(const float *weights, int count) {
+	if (count > _capacity) {
+		clear();
+		_capacity = count;
+		_prob = new float[_capacity];
+		_alias = new int[_capacity];
+		_stack = new int[_capacity];
+	}
+	_count = count;
+	double sum = 0.0;
+	for (int i = 0; i < count; i++)
+		sum += weights[i];
+	// scale the weights so their mean is 1, the slots under 1 are small, the others are large
+	//
+	int small = 0, large = count;
+	for (int i = 0; i < count; i++) {
+		_prob[i] = sum > 0.0 ? (float)(weights[i] * count / sum) : 1.0f;
+		_alias[i] = i;
+		if (_prob[i] < 1.0f)
+			_stack[small++] = i;
+		else
+			_stack[--large] = i;
+	}
+	// fill every small slot up to 1 from a large one, which becomes small when it falls under 1
+	//
+	while (small > 0 && large < count) {
+		int s = _stack[--small];
+		int l = _stack[large];
+		_alias[s] = l;
+		_prob[l] -= 1.0f - _prob[s];
+		if (_prob[l] < 1.0f) {
+			large++;
+			_stack[small++] = l;
+		}
+	}
+	// the slots left over only miss 1 by rounding
+	//
+	while (small > 0)
+		_prob[_stack[--small]] = 1.0f;
+	while (large < count)
+		_prob[_stack[large++]] = 1.0f;
+}
+
+void GAliasTable::clear() {
+	delete[] _prob;
+	delete[] _alias;
+	delete[] _stack;
+	_prob = NULL;
+	_alias = _stack = NULL;
+	_count = _capacity = 0;
+}
+
+
+
+#endif /*__RANDOM_H__*/
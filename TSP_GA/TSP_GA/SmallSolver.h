@@ -0,0 +1,518 @@
+#ifndef __SMALLSOLVER_H__
+#define __SMALLSOLVER_H__
+
+
+
+#include "TSPSolver.h"
+
+#define __SMALL_MIN_VTX__ 3			// smaller instances go to the general solver
+#define __SMALL_MAX_VTX__ 64		// larger instances go to the general solver, the crossovers keep their city sets in 64 bit masks
+#define __SMALL_VTX_STEP__ 8		// the fixed sizes are the multiples of this, the cities count is padded up to the next one
+
+
+// tour of up to N cities stored in place, the positions after the last city repeat the first city,
+// so the padding adds edges of length 0 and the tour length is always the sum of its N edges
+//
+template <int N>
+struct GSmallTour {
+	unsigned char _path[N];		// city ids, padded with the first city
+	float _length;				// tour length
+	unsigned long long _hash;	// GTourHash of the cities, without the padding, only kept with _uniqueTours
+
+	void pad(int vtxCount) { memset(_path + vtxCount, _path[0], N - vtxCount); }
+};
+
+
+// edges I..N-1 of a padded tour summed into 4 independent sums, unrolled at compile time,
+// d is the N x N distance matrix of the solver
+//
+template <int N, int I>
+struct GSmallEdges {
+	static void add(const float *d, const unsigned char *t, float *s) {
+		s[0] += d[t[I] * N + t[I + 1]];
+		s[1] += d[t[I + 1] * N + t[I + 2]];
+		s[2] += d[t[I + 2] * N + t[I + 3]];
+		s[3] += d[t[I + 3] * N + t[(I + 4) % N]];
+		GSmallEdges<N, I + 4>::add(d, t, s);
+	}
+};
+template <int N>
+struct GSmallEdges<N, N> {
+	static void add(const float *, const unsigned char *, float *) {}
+};
+
+template <int N>
+inline float smallTourLength(const float *d, const unsigned char *t) {
+	float s[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	GSmallEdges<N, 0>::add(d, t, s);
+	return (s[0] + s[1]) + (s[2] + s[3]);
+}
+
+
+// order crossover as OX_crossover(), the cities taken from parent1 are kept in a bit mask instead of flags
+//
+inline void smallOX(const unsigned char *parent1, const unsigned char *parent2, unsigned char *child, int a, int b, int m) {
+	unsigned long long used = 0;
+	for (int i = a; i <= b; i++) {
+		child[i] = parent1[i];
+		used |= 1ULL << parent1[i];
+	}
+	int k = b + 1 == m ? 0 : b + 1;
+	for (int i = 0, j = k; i < m; i++) {
+		unsigned char c = parent2[j];
+		if (++j == m)
+			j = 0;
+		if (!(used >> c & 1)) {
+			child[k] = c;
+			if (++k == m)
+				k = 0;
+		}
+	}
+}
+
+// partially mapped crossover as PMX_crossover(), the segment cities are kept in a bit mask
+//
+inline void smallPMX(const unsigned char *parent1, const unsigned char *parent2, unsigned char *child, int a, int b, int m) {
+	unsigned long long used = 0;
+	unsigned char pos[__SMALL_MAX_VTX__];
+	for (int i = a; i <= b; i++) {
+		child[i] = parent1[i];
+		used |= 1ULL << parent1[i];
+		pos[parent1[i]] = (unsigned char)i;
+	}
+	for (int i = 0; i < m; i++) {
+		if (i == a) {
+			i = b;
+			continue;
+		}
+		unsigned char c = parent2[i];
+		while (used >> c & 1)
+			c = parent2[pos[c]];
+		child[i] = c;
+	}
+}
+
+
+// state owned by one worker thread of the small solver
+//
+struct TSPSmallWorker {
+	TSPSmallWorker() : _positionOf(NULL), _crossovers(0), _mutations(0), _evaluations(0), _duplicates(0) {}
+	GRandom _rng;					// random engine of the worker
+	unsigned char _position[__SMALL_MAX_VTX__];	// inverse index of the tour mutated last, with _neighbourMutation
+	const unsigned char *_positionOf;	// path of that tour, NULL once it is changed by anything but mutate()
+	long long _crossovers;			// crossovers since the last generation record
+	long long _mutations;			// mutations since the last generation record
+	long long _evaluations;			// tour length evaluations since the last generation record
+	long long _duplicates;			// duplicate children since the last generation record
+	GTourSet _children;				// hashes of the children of the worker in the current generation, with _uniqueTours
+};
+
+
+// solver of the instances of up to N cities, the same GA as TSPSolverT with the CX, OX and PMX crossovers,
+// mutation and rank-based selection, but the tours are fixed size arrays held in place in one population block,
+// their length is an unrolled sum over a private N x N distance matrix, and the crossovers book the cities in bit masks.
+// it has no island model, local search, nearest neighbour initial tours or checkpoints, create() picks it only without them.
+// with _uniqueTours it rejects the duplicate children but keeps no fitness cache, a length costs no more than a hash here
+//
+template <int N>
+class TSPSmallSolver : public TSPSolver {
+public:
+	TSPSmallSolver(const GVertexStore &vertices, const TSPConfig &config, const GDistanceOracle *dist, const GNeighbours *neighbours);
+	~TSPSmallSolver();
+
+	const TSPResult &solve();
+	bool resume(const char *, const char **error) { if (error) *error = "the small instance solver has no checkpoints"; return false; }
+
+private:
+	float length(const GSmallTour<N> *tour) const { return smallTourLength<N>(_d, tour->_path); }
+	void randomTour(GRandom &rng, GSmallTour<N> *tour);
+	void mutate(TSPSmallWorker &w, GSmallTour<N> *tour);
+	void crossover(TSPSmallWorker &w, const GSmallTour<N> *parent1, const GSmallTour<N> *parent2, GSmallTour<N> *child1, GSmallTour<N> *child2);
+	void admit(TSPSmallWorker &w, GSmallTour<N> *child);
+	void reconcile();
+	int selectSurvivors(int sorted);
+	void updateBest(const GSmallTour<N> *tour);
+	void makeInitialTours(int thread);
+	void makeOffspring(int thread);
+	void recordGeneration(int generation, double offspringSeconds, double selectionSeconds, double generationSeconds);
+
+	static void initialToursTask(void *data, int thread) { ((TSPSmallSolver *)data)->makeInitialTours(thread); }
+	static void offspringTask(void *data, int thread) { ((TSPSmallSolver *)data)->makeOffspring(thread); }
+
+	float *_d;						// distance matrix of the cities, N x N
+	GSmallTour<N> *_tours;			// population block
+	GSmallTour<N> **_list;			// population list, in rank order after the selection
+	GSmallTour<N> **_scratch;		// merge buffer of the sort and loosers buffer of the selection
+	TSPSmallWorker *_workers;		// per thread state, one per pool thread
+	int _threadCount;				// threads count of the current solve
+	int _survivors;					// survivors count of the current generation, the parents
+};
+
+
+template <int N>
+TSPSmallSolver<N>::TSPSmallSolver(const GVertexStore &vertices, const TSPConfig &config, const GDistanceOracle *dist, const GNeighbours *neighbours)
+	: TSPSolver(vertices, config, dist, neighbours), _workers(NULL), _threadCount(0), _survivors(0) {
+	_d = new float[N * N];
+	for (int i = 0; i < N; i++)
+		for (int j = 0; j < N; j++)
+			_d[i * N + j] = i < _vtxCount && j < _vtxCount && i != j ? (*_dist)(i, j) : 0.0f;
+	int count = _config._populationCount;
+	_tours = new GSmallTour<N>[count];
+	_list = new GSmallTour<N> *[count];
+	_scratch = new GSmallTour<N> *[count];
+	for (int i = 0; i < count; i++)
+		_list[i] = _tours + i;
+}
+
+template <int N>
+TSPSmallSolver<N>::~TSPSmallSolver() {
+	delete[] _d;
+	delete[] _tours;
+	delete[] _list;
+	delete[] _scratch;
+	delete[] _workers;
+}
+
+
+template <int N>
+void TSPSmallSolver<N>::randomTour(GRandom &rng, GSmallTour<N> *tour) {
+	for (int i = 0; i < _vtxCount; i++)
+		tour->_path[i] = (unsigned char)i;
+	rng.shuffle(tour->_path, _vtxCount);
+	tour->pad(_vtxCount);
+	tour->_length = length(tour);
+}
+
+// swap two cities as TSPSolverT::mutate(), the padding and the length are updated by the caller
+//
+template <int N>
+void TSPSmallSolver<N>::mutate(TSPSmallWorker &w, GSmallTour<N> *tour) {
+	int r1, r2;
+	if (_config._neighbourMutation && _neighbours) {
+		r1 = w._rng.below(_vtxCount);
+		if (w._positionOf != tour->_path) {
+			for (int i = 0; i < _vtxCount; i++)
+				w._position[tour->_path[i]] = (unsigned char)i;
+			w._positionOf = tour->_path;
+		}
+		int near = (*_neighbours)[tour->_path[r1]][w._rng.below(_neighbours->count())];
+		r2 = w._position[near];
+		int next = r1 + 1 == _vtxCount ? 0 : r1 + 1;
+		if (r2 != next)
+			r1 = next;
+	}
+	else {
+		r1 = w._rng.below(_vtxCount);
+		r2 = w._rng.below(_vtxCount);
+		while (r1 == r2)
+			r2 = w._rng.below(_vtxCount);
+	}
+	unsigned char t = tour->_path[r1];
+	tour->_path[r1] = tour->_path[r2];
+	tour->_path[r2] = t;
+	if (w._positionOf == tour->_path) {
+		w._position[tour->_path[r1]] = (unsigned char)r1;
+		w._position[t] = (unsigned char)r2;
+	}
+	w._mutations++;
+}
+
+// cross over the two parents, child2 may be NULL, the padding and the length are updated by the caller
+//
+template <int N>
+void TSPSmallSolver<N>::crossover(TSPSmallWorker &w, const GSmallTour<N> *parent1, const GSmallTour<N> *parent2, GSmallTour<N> *child1, GSmallTour<N> *child2) {
+	const unsigned char *p1 = parent1->_path;
+	const unsigned char *p2 = parent2->_path;
+	unsigned char *c1 = child1->_path;
+	unsigned char *c2 = child2 ? child2->_path : NULL;
+	int m = _vtxCount;
+	w._positionOf = NULL;
+	if (_config._crossover == G_CROSSOVER_CX) {
+		unsigned char pos[N];
+		CX_crossover(p1, p2, c1, c2, pos, m);
+	}
+	else {
+		int a = w._rng.below(m), b = w._rng.below(m);
+		if (a > b) { int t = a; a = b; b = t; }
+		if (_config._crossover == G_CROSSOVER_OX) {
+			smallOX(p1, p2, c1, a, b, m);
+			if (c2)
+				smallOX(p2, p1, c2, a, b, m);
+		}
+		else {
+			smallPMX(p1, p2, c1, a, b, m);
+			if (c2)
+				smallPMX(p2, p1, c2, a, b, m);
+		}
+	}
+	w._crossovers++;
+}
+
+// rank-based selection as TSPSolverT::selectSurvivors(), on the population list
+//
+template <int N>
+int TSPSmallSolver<N>::selectSurvivors(int sorted) {
+	int count = _config._populationCount;
+	if (sorted < count - 1)
+		mergeSort(_list, _scratch, sorted, count - 1);
+	if (sorted > 0 && sorted < count && _list[sorted]->_length < _list[sorted - 1]->_length)
+		merge(_list, _scratch, 0, sorted - 1, count - 1);
+	// the coin of every tour is random, so the partition is branch free: the tour is written to both lists
+	// and only the position of the list it goes to moves on
+	//
+	int k = 0, l = 0;
+	float step = 1.0f / count;
+	for (int i = 0; i < count; i++) {
+		GSmallTour<N> *tour = _list[i];
+		int survives = _rng.uniform() < 1.0f - i * step;
+		_list[k] = tour;
+		_scratch[l] = tour;
+		k += survives;
+		l += 1 - survives;
+	}
+	memcpy(_list + k, _scratch, l * sizeof(GSmallTour<N> *));
+	return k;
+}
+
+// copy the tour into the best tour of the solver, through a path view of its cities
+//
+template <int N>
+void TSPSmallSolver<N>::updateBest(const GSmallTour<N> *tour) {
+	GPath<unsigned char> view;
+	view._path = (unsigned char *)tour->_path;
+	view._length = tour->_length;
+	updateBestTour(&view);
+}
+
+// keep a child out of the tour set as TSPSolverT::admit(), but the looser is already overwritten,
+// so a child still duplicate after the mutations stays in the population
+//
+template <int N>
+void TSPSmallSolver<N>::admit(TSPSmallWorker &w, GSmallTour<N> *child) {
+	child->_hash = _tourHash.tour(child->_path);
+	for (int r = 0; r < __UNIQUE_RETRIES__; r++) {
+		if (!_tourSet.contains(child->_hash) && w._children.insert(child->_hash))
+			return;
+		w._duplicates++;
+		mutate(w, child);
+		child->pad(_vtxCount);
+		child->_length = length(child);
+		child->_hash = _tourHash.tour(child->_path);
+		w._evaluations++;
+	}
+	// the last mutation may have made it new, so it joins the set and its later copies are rejected
+	//
+	if (_tourSet.contains(child->_hash) || !w._children.insert(child->_hash))
+		w._duplicates++;
+}
+
+// add the children to the tour set in index order once they are all made, as TSPSolverT::reconcile()
+//
+template <int N>
+void TSPSmallSolver<N>::reconcile() {
+	TSPSmallWorker &w = _workers[0];
+	for (int k = _survivors; k < _config._populationCount; k++) {
+		GSmallTour<N> *tour = _list[k];
+		if (_tourSet.insert(tour->_hash))
+			continue;
+		w._positionOf = NULL;
+		for (int r = 0; r < __UNIQUE_RETRIES__; r++) {
+			w._duplicates++;
+			mutate(w, tour);
+			tour->pad(_vtxCount);
+			tour->_length = length(tour);
+			tour->_hash = _tourHash.tour(tour->_path);
+			w._evaluations++;
+			if (_tourSet.insert(tour->_hash))
+				break;
+		}
+	}
+}
+
+template <int N>
+void TSPSmallSolver<N>::makeInitialTours(int thread) {
+	int count = _config._populationCount;
+	for (int i = count * thread / _threadCount; i < count * (thread + 1) / _threadCount; i++) {
+		randomTour(_workers[thread]._rng, _list[i]);
+		if (_config._uniqueTours)
+			_list[i]->_hash = _tourHash.tour(_list[i]->_path);
+	}
+}
+
+// worker part of a generation as TSPSolverT::makeOffspring(), the children are made in place of the loosers they replace,
+// as no looser is a parent
+//
+template <int N>
+void TSPSmallSolver<N>::makeOffspring(int thread) {
+	TSPSmallWorker &w = _workers[thread];
+	int count = _config._populationCount;
+	int pairs = (count - _survivors + 1) / 2;
+	if (_config._uniqueTours)
+		w._children.reset();
+	for (int j = pairs * thread / _threadCount; j < pairs * (thread + 1) / _threadCount; j++) {
+		int k = _survivors + 2 * j;
+		int p1 = _parents.draw(w._rng);
+		int p2 = _parents.draw(w._rng);
+		while (_survivors > 1 && p1 == p2)
+			p2 = _parents.draw(w._rng);
+		GSmallTour<N> *child1 = _list[k];
+		GSmallTour<N> *child2 = k + 1 < count ? _list[k + 1] : NULL;
+		crossover(w, _list[p1], _list[p2], child1, child2);
+		if (_config._mutationProb != 0.0f && w._rng.uniform() < _config._mutationProb)
+			mutate(w, child1);
+		child1->pad(_vtxCount);
+		child1->_length = length(child1);
+		if (child2) {
+			if (_config._mutationProb != 0.0f && w._rng.uniform() < _config._mutationProb)
+				mutate(w, child2);
+			child2->pad(_vtxCount);
+			child2->_length = length(child2);
+		}
+		w._evaluations += child2 ? 2 : 1;
+		if (_config._uniqueTours) {
+			admit(w, child1);
+			if (child2)
+				admit(w, child2);
+		}
+		if (_stopComputing.load(std::memory_order_relaxed) || ((j + 1) % __DEADLINE_POLL__ == 0 && deadlineReached()))
+			return;
+	}
+}
+
+template <int N>
+void TSPSmallSolver<N>::recordGeneration(int generation, double offspringSeconds, double selectionSeconds, double generationSeconds) {
+	int count = _config._populationCount;
+	TSPGenerationStats stats;
+	stats._generation = generation;
+	stats._island = 0;
+	double sum = 0.0;
+	float worst = 0.0f;
+	for (int i = 0; i < count; i++) {
+		sum += _list[i]->_length;
+		if (_list[i]->_length > worst)
+			worst = _list[i]->_length;
+	}
+	stats._best = _list[0]->_length;
+	stats._mean = (float)(sum / count);
+	stats._worst = worst;
+	long long crossovers = 0, mutations = 0, evaluations = 0, duplicates = 0;
+	for (int t = 0; t < _threadCount; t++) {
+		crossovers += _workers[t]._crossovers;
+		mutations += _workers[t]._mutations;
+		evaluations += _workers[t]._evaluations;
+		duplicates += _workers[t]._duplicates;
+		_workers[t]._crossovers = _workers[t]._mutations = _workers[t]._evaluations = _workers[t]._duplicates = 0;
+	}
+	stats._crossovers = (int)crossovers;
+	stats._mutations = (int)mutations;
+	stats._evaluations = (int)evaluations;
+	stats._duplicates = (int)duplicates;
+	stats._cacheHits = 0;
+	stats._evalsPerSecond = generationSeconds > 0.0 ? evaluations / generationSeconds : 0.0;
+	stats._offspringSeconds = offspringSeconds;
+	stats._selectionSeconds = selectionSeconds;
+	stats._seconds = elapsed();
+	_telemetry->record(stats);
+}
+
+
+// the generation loop of TSPSolverT::solve(), with the same terminations
+//
+template <int N>
+const TSPResult &TSPSmallSolver<N>::solve() {
+	_start = std::chrono::steady_clock::now();
+	startDeadline();
+	_result = TSPResult();
+	_result._bestTour = _bestTour;
+	_stopComputing = false;
+	_rng.seed(_config._seed);
+	_parents.configure(_config);
+	if (_config._uniqueTours)
+		allocateUnique();
+	GThreadPool pool(_config._threadCount > 0 ? _config._threadCount : GThreadPool::hardwareThreads());
+	_threadCount = pool.threadCount();
+	delete[] _workers;
+	_workers = new TSPSmallWorker[_threadCount];
+	for (int t = 0; t < _threadCount; t++) {
+		_workers[t]._rng.seed(_config._seed ? _config._seed + ((unsigned long long)(t + 1) << 32) : 0);
+		if (_config._uniqueTours)
+			_workers[t]._children.allocate(_config._populationCount / _threadCount + 2);
+	}
+	for (int i = 0; i < _config._populationCount; i++)
+		_list[i] = _tours + i;
+	pool.run(initialToursTask, this);
+	updateBest(_list[0]);
+	_survivors = selectSurvivors(0);
+	int lastImprovement = 0;
+	for (int i = 0; _config._generationIter <= 0 || i < _config._generationIter; i++) {
+		std::chrono::steady_clock::time_point generationStart, tick;
+		if (_telemetry)
+			generationStart = tick = std::chrono::steady_clock::now();
+		_parents.prepare(_list, _survivors);
+		if (_config._uniqueTours)
+			resetTourSet(_list, _survivors);
+		pool.run(offspringTask, this);
+		if (_config._uniqueTours)
+			reconcile();
+		double offspringSeconds = _telemetry ? lap(tick) : 0.0;
+		if (_stopComputing) {
+			_result._stopped = true;
+			_result._stopReason = _deadlineReached ? TSP_STOP_DEADLINE : TSP_STOP_USER;
+			break;
+		}
+		_survivors = selectSurvivors(_survivors);
+		double selectionSeconds = _telemetry ? lap(tick) : 0.0;
+		bool improved = false;
+		if (_list[0]->_length < _bestTour->_length) {
+			updateBest(_list[0]);
+			improved = true;
+			lastImprovement = i + 1;
+		}
+		_result._generations = i + 1;
+		if (_telemetry)
+			recordGeneration(i, offspringSeconds, selectionSeconds, lap(generationStart));
+		if (_callback)
+			_callback(this, i, improved, _callbackData);
+		if (_config._targetLength > 0.0f && _bestTour->_length <= _config._targetLength)
+			_result._stopReason = TSP_STOP_TARGET;
+		else if (_config._stallGenerations > 0 && i + 1 - lastImprovement >= _config._stallGenerations)
+			_result._stopReason = TSP_STOP_STALL;
+		else if (deadlineReached())
+			_result._stopReason = TSP_STOP_DEADLINE;
+		if (_result._stopReason != TSP_STOP_GENERATIONS)
+			break;
+	}
+	_result._seconds = elapsed();
+	return _result;
+}
+
+
+
+// make the fixed size solver for the cities count padded up to the next size step,
+// NULL if the cities count or the config need the general solver.
+// a crossover fixed at compile time by __TSP_CROSSOVER__ always goes to the general solver
+//
+TSPSolver *makeSmallSolver(const GVertexStore &vertices, const TSPConfig &config, const GDistanceOracle *dist, const GNeighbours *neighbours) {
+#ifndef __TSP_CROSSOVER__
+	if (!config._smallSolver || vertices._count < __SMALL_MIN_VTX__ || vertices._count > __SMALL_MAX_VTX__ || config._populationCount < 2
+		|| config._islandCount > 1 || config._localSearch != TSP_LS_NONE || config._greedyCount > 0 || config._checkpointPath
+		|| (config._crossover != G_CROSSOVER_CX && config._crossover != G_CROSSOVER_OX && config._crossover != G_CROSSOVER_PMX))
+		return NULL;
+	switch ((vertices._count + __SMALL_VTX_STEP__ - 1) / __SMALL_VTX_STEP__) {
+	case 1: return new TSPSmallSolver<8>(vertices, config, dist, neighbours);
+	case 2: return new TSPSmallSolver<16>(vertices, config, dist, neighbours);
+	case 3: return new TSPSmallSolver<24>(vertices, config, dist, neighbours);
+	case 4: return new TSPSmallSolver<32>(vertices, config, dist, neighbours);
+	case 5: return new TSPSmallSolver<40>(vertices, config, dist, neighbours);
+	case 6: return new TSPSmallSolver<48>(vertices, config, dist, neighbours);
+	case 7: return new TSPSmallSolver<56>(vertices, config, dist, neighbours);
+	default: return new TSPSmallSolver<64>(vertices, config, dist, neighbours);
+	}
+#else
+	return NULL;
+#endif
+}
+
+
+
+#endif /*__SMALLSOLVER_H__*/
@@ -0,0 +1,299 @@
+#ifndef __SPATIALINDEX_H__
+#define __SPATIALINDEX_H__
+
+
+
+#include <cstring>
+#include <cfloat>
+
+#include "Graph.h"
+
+#define __GRID_CITIES_PER_CELL__ 2		// mean cities count of a grid cell
+#define __NEIGHBOURS_MAX__ 32			// longest neighbour list
+
+
+// uniform grid over the cities of a vertex store, built once per city set,
+// the cities of a cell are stored together, so a query only visits the cells around its position
+//
+class GSpatialIndex {
+public:
+	GSpatialIndex() : _x(NULL), _y(NULL), _vtxCount(0), _cols(0), _rows(0), _cellStart(NULL), _cellCities(NULL) {}
+	~GSpatialIndex() { clear(); }
+
+	void build(const GVertexStore &vertices);		// (re)build the grid for the given cities, which must outlive it
+	void clear();
+
+	int cellCount() const { return _cols * _rows; }
+	int cell(int city) const { return cellRow(_y[city]) * _cols + cellCol(_x[city]); }
+
+	// the count nearest cities of the given city, nearest first, written into out, return the count found
+	//
+	int nearest(int city, int count, int *out) const;
+
+	// nearest city of the given city whose visited flag is not set, -1 if all are visited,
+	// left holds the count of not visited cities of every cell, so the empty cells are skipped
+	//
+	int nearestUnvisited(int city, const char *visited, const int *left) const;
+
+	// count of the cities of every cell, the initial left counts of nearestUnvisited()
+	//
+	void cellCounts(int *left) const {
+		for (int c = 0; c < cellCount(); c++)
+			left[c] = _cellStart[c + 1] - _cellStart[c];
+	}
+
+private:
+	GSpatialIndex(const GSpatialIndex &);
+	GSpatialIndex &operator=(const GSpatialIndex &);
+
+	int cellCol(float x) const { int c = (int)((x - _x0) * _invCell); return c < 0 ? 0 : c >= _cols ? _cols - 1 : c; }
+	int cellRow(float y) const { int r = (int)((y - _y0) * _invCell); return r < 0 ? 0 : r >= _rows ? _rows - 1 : r; }
+	float sqDistance(int i, int j) const { float dx = _x[i] - _x[j], dy = _y[i] - _y[j]; return dx * dx + dy * dy; }
+	float ringClearance(int city, int ring) const;
+
+	const float *_x;			// x positions of the cities, owned by the vertex store
+	const float *_y;			// y positions of the cities, owned by the vertex store
+	int _vtxCount;				// cities count
+	float _x0, _y0;				// top left corner of the grid
+	float _cellSize;			// side of a square cell
+	float _invCell;				// 1 / _cellSize
+	int _cols, _rows;			// grid size in cells
+	int *_cellStart;			// first entry of every cell in _cellCities, cellCount() + 1 entries
+	int *_cellCities;			// cities sorted by cell
+};
+
+
+void GSpatialIndex::clear() {
+	delete[] _cellStart;
+	delete[] _cellCities;
+	_cellStart = _cellCities = NULL;
+	_x = _y = NULL;
+	_vtxCount = _cols = _rows = 0;
+}
+
+// the cities are bucketed into the cells by a counting sort, O(n)
+//
+void GSpatialIndex::build(const GVertexStore &vertices) {
+	clear();
+	_x = vertices._x;
+	_y = vertices._y;
+	_vtxCount = vertices._count;
+	if (!_vtxCount)
+		return;
+	float x1 = _x[0], y1 = _y[0];
+	_x0 = x1;
+	_y0 = y1;
+	for (int i = 1; i < _vtxCount; i++) {
+		if (_x[i] < _x0) _x0 = _x[i];
+		if (_x[i] > x1) x1 = _x[i];
+		if (_y[i] < _y0) _y0 = _y[i];
+		if (_y[i] > y1) y1 = _y[i];
+	}
+	float w = x1 - _x0, h = y1 - _y0;
+	float area = (w > 0.0f ? w : 1.0f) * (h > 0.0f ? h : 1.0f);
+	_cellSize = sqrtf(area * __GRID_CITIES_PER_CELL__ / _vtxCount);
+	if (_cellSize <= 0.0f)
+		_cellSize = 1.0f;
+	_invCell = 1.0f / _cellSize;
+	_cols = (int)(w * _invCell) + 1;
+	_rows = (int)(h * _invCell) + 1;
+	_cellStart = new int[cellCount() + 1];
+	_cellCities = new int[_vtxCount];
+	memset(_cellStart, 0, (cellCount() + 1) * sizeof(int));
+	for (int i = 0; i < _vtxCount; i++)
+		_cellStart[cell(i) + 1]++;
+	for (int c = 0; c < cellCount(); c++)
+		_cellStart[c + 1] += _cellStart[c];
+	int *fill = new int[cellCount()];
+	memcpy(fill, _cellStart, cellCount() * sizeof(int));
+	for (int i = 0; i < _vtxCount; i++)
+		_cellCities[fill[cell(i)]++] = i;
+	delete[] fill;
+}
+
+// distance from the city to the outside of the square of cells of the given ring around its cell,
+// no city beyond the ring can be nearer than that
+//
+float GSpatialIndex::ringClearance(int city, int ring) const {
+	int col = cellCol(_x[city]), row = cellRow(_y[city]);
+	float left = _x[city] - (_x0 + (col - ring) * _cellSize);
+	float right = _x0 + (col + ring + 1) * _cellSize - _x[city];
+	float top = _y[city] - (_y0 + (row - ring) * _cellSize);
+	float bottom = _y0 + (row + ring + 1) * _cellSize - _y[city];
+	float d = left < right ? left : right;
+	d = d < top ? d : top;
+	return d < bottom ? d : bottom;
+}
+
+// the rings of cells around the city are searched outwards, the best count cities are kept by insertion,
+// the search stops when no city beyond the current ring can enter the list
+//
+int GSpatialIndex::nearest(int city, int count, int *out) const {
+	float dist[__NEIGHBOURS_MAX__];
+	if (count > __NEIGHBOURS_MAX__)
+		count = __NEIGHBOURS_MAX__;
+	if (count > _vtxCount - 1)
+		count = _vtxCount - 1;
+	int found = 0;
+	int col = cellCol(_x[city]), row = cellRow(_y[city]);
+	int maxRing = _cols > _rows ? _cols : _rows;
+	for (int ring = 0; ring <= maxRing; ring++) {
+		for (int r = row - ring; r <= row + ring; r++) {
+			if (r < 0 || r >= _rows)
+				continue;
+			// inner rows of the ring only have their two end cells
+			//
+			int step = (r == row - ring || r == row + ring) ? 1 : 2 * ring;
+			for (int c = col - ring; c <= col + ring; c += step ? step : 1) {
+				if (c < 0 || c >= _cols)
+					continue;
+				int cellId = r * _cols + c;
+				for (int e = _cellStart[cellId]; e < _cellStart[cellId + 1]; e++) {
+					int other = _cellCities[e];
+					if (other == city)
+						continue;
+					float d = sqDistance(city, other);
+					if (found == count && d >= dist[found - 1])
+						continue;
+					int k = found < count ? found++ : found - 1;
+					while (k > 0 && dist[k - 1] > d) {
+						dist[k] = dist[k - 1];
+						out[k] = out[k - 1];
+						k--;
+					}
+					dist[k] = d;
+					out[k] = other;
+				}
+			}
+		}
+		if (found == count) {
+			float clear = ringClearance(city, ring);
+			if (clear * clear >= dist[found - 1])
+				break;
+		}
+	}
+	return found;
+}
+
+int GSpatialIndex::nearestUnvisited(int city, const char *visited, const int *left) const {
+	int best = -1;
+	float bestDist = FLT_MAX;
+	int col = cellCol(_x[city]), row = cellRow(_y[city]);
+	int maxRing = _cols > _rows ? _cols : _rows;
+	for (int ring = 0; ring <= maxRing; ring++) {
+		for (int r = row - ring; r <= row + ring; r++) {
+			if (r < 0 || r >= _rows)
+				continue;
+			int step = (r == row - ring || r == row + ring) ? 1 : 2 * ring;
+			for (int c = col - ring; c <= col + ring; c += step ? step : 1) {
+				if (c < 0 || c >= _cols)
+					continue;
+				int cellId = r * _cols + c;
+				if (!left[cellId])
+					continue;
+				for (int e = _cellStart[cellId]; e < _cellStart[cellId + 1]; e++) {
+					int other = _cellCities[e];
+					if (visited[other])
+						continue;
+					float d = sqDistance(city, other);
+					if (d < bestDist) {
+						bestDist = d;
+						best = other;
+					}
+				}
+			}
+		}
+		if (best >= 0) {
+			float clear = ringClearance(city, ring);
+			if (clear * clear >= bestDist)
+				break;
+		}
+	}
+	return best;
+}
+
+
+
+// lists of the nearest neighbours of every city, nearest first, the move candidates of mutation and local search,
+// built once per city set from the spatial index, which is kept for the nearest neighbour tours
+//
+class GNeighbours {
+public:
+	GNeighbours() : _lists(NULL), _count(0), _vtxCount(0) {}
+	GNeighbours(const GVertexStore &vertices, int count) : _lists(NULL), _count(0), _vtxCount(0) { build(vertices, count); }
+	~GNeighbours() { clear(); }
+
+	void build(const GVertexStore &vertices, int count);		// (re)build count neighbours of every city
+	void clear();
+
+	int count() const { return _count; }						// neighbours count of every list
+	const int *lists() const { return _lists; }				// all lists, count() entries per city
+	const int *operator[](int city) const { return _lists + city * _count; }
+	const GSpatialIndex &index() const { return _index; }
+
+private:
+	GNeighbours(const GNeighbours &);
+	GNeighbours &operator=(const GNeighbours &);
+
+	GSpatialIndex _index;		// grid of the cities
+	int *_lists;				// neighbour lists
+	int _count;					// neighbours count of every list
+	int _vtxCount;				// cities count
+};
+
+
+void GNeighbours::clear() {
+	delete[] _lists;
+	_lists = NULL;
+	_count = _vtxCount = 0;
+	_index.clear();
+}
+
+void GNeighbours::build(const GVertexStore &vertices, int count) {
+	clear();
+	_vtxCount = vertices._count;
+	_count = count < _vtxCount - 1 ? count : _vtxCount - 1;
+	if (_count > __NEIGHBOURS_MAX__)
+		_count = __NEIGHBOURS_MAX__;
+	if (_count <= 0) {
+		_count = 0;
+		return;
+	}
+	_index.build(vertices);
+	_lists = new int[_vtxCount * _count];
+	for (int i = 0; i < _vtxCount; i++)
+		_index.nearest(i, _count, _lists + i * _count);
+}
+
+
+
+// function to build a nearest neighbour tour from the given start city into tour,
+// the next city is the nearest not visited neighbour, or the nearest not visited city of the grid when all neighbours are visited,
+// visited and left are caller scratch buffers of vtxCount and index().cellCount() entries
+//
+template <typename TIdx>
+void nearestNeighbourTour(const GNeighbours &neighbours, int vtxCount, int start, TIdx *tour, char *visited, int *left) {
+	const GSpatialIndex &index = neighbours.index();
+	memset(visited, 0, vtxCount);
+	index.cellCounts(left);
+	int city = start;
+	for (int i = 0; i < vtxCount; i++) {
+		tour[i] = (TIdx)city;
+		visited[city] = 1;
+		left[index.cell(city)]--;
+		if (i == vtxCount - 1)
+			break;
+		int next = -1;
+		const int *list = neighbours[city];
+		for (int k = 0; k < neighbours.count() && next < 0; k++)
+			if (!visited[list[k]])
+				next = list[k];
+		if (next < 0)
+			next = index.nearestUnvisited(city, visited, left);
+		city = next;
+	}
+}
+
+
+
+#endif /*__SPATIALINDEX_H__*/
@@ -13,13 +13,17 @@
 #include <FL/Fl_Browser.H>
 #include <FL/Fl_Tile.H>
 #include <FL/Fl_Progress.H>
+#include <FL/Fl_File_Chooser.H>
+#include <FL/fl_ask.H>
 
 #include <ctime>
+#include <atomic>
 
 #include "threads.h"
 Fl_Thread GA_thread;
 
-#include "Graph.h"
+#include "TSPSolver.h"
+#include "TSPLIB.h"
 
 // UI Config
 //
@@ -30,8 +34,8 @@ Fl_Thread GA_thread;
 #define __Graph_W 900		// graph window initial width
 #define __Graph_H 600		// graph window initial height
 #define __Ctrl_Col 1080
-
-#define __INF_LEN_TOUR__ 9999999	// infinite tour length
+#define __Frame_Seconds (1.0 / 30)	// period of the UI updates while computing, at most 30 redraws per second
+#define __Neighbour_Count 8	// nearest neighbours of every city, the candidates of the local search
 
 int __vtxRadius = 5;		// city radius
 Fl_Color __vtxColor = FL_RED;		// color of cities
@@ -47,7 +51,9 @@ Fl_Slider *verticesCountSlider;			//cities count slider
 Fl_Slider *generationIterSlider;		// generation iteration count slider
 Fl_Slider *populationCountSlider;		// choromosomes count slider
 Fl_Slider *mutationPercentSlider;		// mutation percentage slider
+Fl_Check_Button *localSearchCheck;		// memetic mode check box, local search on every child
 Fl_Button *graphGenButton;				// generate graph button
+Fl_Button *graphLoadButton;				// load TSPLIB instance button
 Fl_Button *computeTSPButton;			// computTSP button
 Fl_Button *StopComputingButton;			// stop computing button
 Fl_Browser *infoBarBrowser;				// info box widget
@@ -62,12 +68,23 @@ Fl_Progress *progressBar;				// progress bar widget
 Fl_Box **__vtxIdLabels;		// city id labels
 #endif
 
+GVertexStore __vertices;			// cities
+GRandom __rng;						// random engine of the UI thread, places the cities
+GDistanceOracle __distOracle;		// distance oracle of the current cities
+GNeighbours __neighbours;			// nearest neighbour lists of the current cities
 int __gVtxCount;				// cities count
 int __generationIter;			// generation itertion count
 int __toursPopulationCount;		// population (chromosomes) count in each generation
 float __mutationProb;			// mutation percentage
 
-bool __stopComputing = false;	// stop condition flag
+float __viewX0 = 0.0f, __viewY0 = 0.0f;		// top left position of the area of the cities shown in the graph window
+float __viewW = __Graph_W, __viewH = __Graph_H;	// size of the area of the cities shown in the graph window
+
+TSPSolver *__solver = NULL;			// solver of the current cities, made and deleted by the UI thread only
+GTourExchange __bestTours;			// best tours published by the solver, read by the UI thread
+const GTourSnapshot *__shownTour = NULL;	// best tour drawn, owned by the exchange and kept until the next pull
+unsigned __shownSerial = 0;			// publication number of the best tour drawn
+std::atomic<int> __generationDone(0);	// generations completed by the running solver
 
 
 // main window widget
@@ -100,6 +117,36 @@ public:
 }*graphWindow;
 
 
+// functions to map a city position to the graph window
+//
+int screenX(float x, int w) { return (int)((x - __viewX0) * w / __viewW); }
+int screenY(float y, int h) { return (int)((y - __viewY0) * h / __viewH); }
+
+
+// function to set the shown area to the bounding box of the cities with a small margin,
+// the area keeps the aspect ratio of the graph window so the instance is not distorted
+//
+void fitView() {
+	float x0 = __vertices._x[0], x1 = x0, y0 = __vertices._y[0], y1 = y0;
+	for (int i = 1; i < __vertices._count; i++) {
+		if (__vertices._x[i] < x0) x0 = __vertices._x[i];
+		if (__vertices._x[i] > x1) x1 = __vertices._x[i];
+		if (__vertices._y[i] < y0) y0 = __vertices._y[i];
+		if (__vertices._y[i] > y1) y1 = __vertices._y[i];
+	}
+	float w = (x1 - x0) * 1.04f + 1.0f;
+	float h = (y1 - y0) * 1.04f + 1.0f;
+	if (w * __Graph_H < h * __Graph_W)
+		w = h * __Graph_W / __Graph_H;
+	else
+		h = w * __Graph_H / __Graph_W;
+	__viewW = w;
+	__viewH = h;
+	__viewX0 = (x0 + x1 - w) / 2.0f;
+	__viewY0 = (y0 + y1 - h) / 2.0f;
+}
+
+
 // override draw method to display Graph
 //
 void GraphWindow::draw() {
@@ -109,26 +156,21 @@ void GraphWindow::draw() {
 
 	// draw the cities
 	//
-	if (__GVerices)  {
+	if (__vertices._count)  {
 		for (int i = 0; i < __gVtxCount; i++) {
 			fl_color(__vtxColor);
-			int x = __GVerices[i]._x * w() / __Graph_W;
-			int y = __GVerices[i]._y * h() / __Graph_H;
-			fl_circle(x, y, __vtxRadius);
+			fl_circle(screenX(__vertices._x[i], w()), screenY(__vertices._y[i], h()), __vtxRadius);
 		}
 	}
 
 	// draw the best path
-	if (__bestTour) {
+	if (__shownTour && __shownTour->_serial) {
 		fl_color(__bestPathColor);
 		fl_line_style(FL_DASH, 3);
-		GEdgeVertex *path = __bestTour->_path;
+		const unsigned *path = __shownTour->_path;
 		for (int j = 0; j < __gVtxCount; j++) {
-			int x = path[j]._x * w() / __Graph_W;
-			int y = path[j]._y * h() / __Graph_H;
-			int x2 = path[(j + 1) % __gVtxCount]._x * w() / __Graph_W;
-			int y2 = path[(j + 1) % __gVtxCount]._y * h() / __Graph_H;
-			fl_line(x, y, x2, y2);
+			unsigned v = path[j], v2 = path[(j + 1) % __gVtxCount];
+			fl_line(screenX(__vertices._x[v], w()), screenY(__vertices._y[v], h()), screenX(__vertices._x[v2], w()), screenY(__vertices._y[v2], h()));
 		}
 	}
 }
@@ -137,9 +179,9 @@ void GraphWindow::draw() {
 
 // function to write information into the info browser widget
 //
-void writeInfo(const GPath *tour) {
+void writeInfo(float length) {
 	char infoStr[20];
-	sprintf_s(infoStr, 20, "%.2f", tour->_length);
+	sprintf_s(infoStr, 20, "%.2f", length);
 	infoBarBrowser->add(infoStr);
 	infoBarBrowser->bottomline(infoBarBrowser->size());
 }
@@ -149,6 +191,7 @@ void writeInfo(const GPath *tour) {
 //
 void deactivateUI() {
 	graphGenButton->deactivate();
+	graphLoadButton->deactivate();
 	computeTSPButton->deactivate();
 	mainWindow->redraw();
 }
@@ -157,6 +200,7 @@ void deactivateUI() {
 //
 void activateUI() {
 	graphGenButton->activate();
+	graphLoadButton->activate();
 	computeTSPButton->activate();
 	infoBarBrowser->add("computation complete");
 	infoBarBrowser->add("----------------------------");
@@ -182,38 +226,41 @@ void writeHeaderInfo() {
 
 
 
-// call back function to generate random cities
+// function to drop the current cities with their solver, best tour and distance oracle
 //
-void generateCities(Fl_Widget *, void *) {
+void dropCities() {
 	// check if there exist previously generated cities, 
 	// garbage collect all cities
 	//
-	if (__GVerices) {
-		delete[] __GVerices;
-		__GVerices = NULL;
-
+	if (__vertices._count) {
 #ifdef __DRAW_VID__
-		for (int i = 0; i < __gVtxCount; i++)	{ delete __vtxIdLabels[i]; __vtxIdLabels[i] = NULL; }
+		for (int i = 0; __vtxIdLabels && i < __gVtxCount; i++)	{ delete __vtxIdLabels[i]; __vtxIdLabels[i] = NULL; }
 		delete[] __vtxIdLabels;
 		__vtxIdLabels = NULL;
 #endif
 	}
-	// garbage collect all previously generated tours
+	// delete the current solver, its population and best tour, if it exists
 	//
-	if (__toursPopulationList) {
-		for (int i = 0; i < __gVtxCount; i++) {
-			delete[] __toursPopulationList[i]->_path;
-			__toursPopulationList[i]->_path = NULL;
-		}
-		delete[] __toursPopulationList;
-		__toursPopulationList = NULL;
+	__shownTour = NULL;
+	__bestTours.clear();
+	if (__solver) {
+		delete __solver;
+		__solver = NULL;
 	}
-	// delete the current best tour if it exists
+	// the oracle refers to the positions of the cities, drop it with them
 	//
-	if (__bestTour) {
-		delete __bestTour;
-		__bestTour = NULL;
-	}
+	__distOracle.clear();
+	__neighbours.clear();
+	__vertices.clear();
+	__gVtxCount = 0;
+}
+
+
+
+// call back function to generate random cities
+//
+void generateCities(Fl_Widget *, void *) {
+	dropCities();
 	// set vertices count variable fro UI
 	//
 	__gVtxCount = (int)verticesCountSlider->value();
@@ -221,27 +268,29 @@ void generateCities(Fl_Widget *, void *) {
 	//
 	if (__gVtxCount == 0)
 		return;
-	// create new vertices array
-	//
-	__GVerices = new GEdgeVertex[__gVtxCount];
 #ifdef __DRAW_VID__
 	__vtxIdLabels = new Fl_Box *[__gVtxCount];	// create vId labels if __DRAW_VID__ is defined
 #endif
 	// set vertices positions randomly
 	//
-	for (int i = 0; i < __gVtxCount; i++) {
-		__GVerices[i]._vid = i;
-		__GVerices[i]._x = rand() % __Graph_W;
-		__GVerices[i]._y = rand() % __Graph_H;
+	randomVertices(__vertices, __gVtxCount, __Graph_W, __Graph_H, __rng);
+	__viewX0 = __viewY0 = 0.0f;
+	__viewW = __Graph_W;
+	__viewH = __Graph_H;
+	// build the distance oracle and the neighbour lists once for this city set, shared by every solver run on it
+	//
+	__distOracle.build(__vertices);
+	__neighbours.build(__vertices, __Neighbour_Count);
 #ifdef __DRAW_VID__
+	for (int i = 0; i < __gVtxCount; i++) {
 		// draw vId labels if __DRAW_VID__ is defined
 		//
 		char vIdStr[4];
 		sprintf_s(vIdStr, 4, "%d", i);
 		fl_color(FL_WHITE);
-		__vtxIdLabels[i] = new Fl_Box(__GVerices[i]._x, __GVerices[i]._y, 50, 50, "1");
-#endif
+		__vtxIdLabels[i] = new Fl_Box((int)__vertices._x[i], (int)__vertices._y[i], 50, 50, "1");
 	}
+#endif
 	// write info
 	//
 	infoBarBrowser->add("------------------------------");
@@ -254,416 +303,143 @@ void generateCities(Fl_Widget *, void *) {
 
 
 
-// function to check if there exist given index in the given list,
-// return true if so, otherwise return false
+// call back function to load the cities of a TSPLIB .tsp file
 //
-bool isInList(int *list, int indx, int count) {
-	for (int i = 0; i < count; i++) {
-		if (list[i] == indx)
-			return true;
-	}
-	return false;
-}
-
-
-
-// function to generated random permutaion list of indicies,
-// reutrn a permutation list of integer array
-//
-int *permutaionList() {
-	int *pList = new int[__gVtxCount];
-	for (int i = 0; i < __gVtxCount; i++) {
-		int r = (int)rand() % __gVtxCount;
-		while (isInList(pList, r, i)) {
-			r = (int)rand() % __gVtxCount;
-		}
-		pList[i] = r;
-	}
-	return pList;
-}
-
-
-
-// function to generate a random path, tour indeed, based on the random permutation integer list,
-// return gPath as a random path
-//
-GPath *generateRandPath() {
-	GPath *gPath = new GPath;
-	gPath->_path = new GEdgeVertex[__gVtxCount];
-	int *pList = permutaionList();
-	for (int i = 0; i < __gVtxCount; i++)
-		gPath->_path[i] = __GVerices[pList[i]];
-	for (int i = 0; i < __gVtxCount; i++)
-		gPath->updateLength();
-	return gPath;
-}
-
-
-
-// function to generate the initial population, random chromosomes,
-// set __toursPopulationList variable
-//
-void initiatePopulation() {
-	srand(clock());
-	if (__toursPopulationList) {
-		for (int i = 0; i < __toursPopulationCount; i++) {
-			delete[] __toursPopulationList[i]->_path;
-			__toursPopulationList[i]->_path = NULL;
-		}
-		delete[] __toursPopulationList;
-		__toursPopulationList = NULL;
-	}
-	__toursPopulationCount = (int)populationCountSlider->value();
-	__toursPopulationList = new GPath *[__toursPopulationCount];
-	for (int i = 0; i < __toursPopulationCount; i++) {
-		__toursPopulationList[i] = generateRandPath();
+void loadCities(Fl_Widget *, void *) {
+	const char *path = fl_file_chooser("Load TSPLIB instance", "*.tsp", NULL);
+	if (!path)
+		return;
+	dropCities();
+	const char *error;
+	if (!loadTSPLIB(path, __vertices, &error)) {
+		fl_alert("%s: %s", path, error);
+		graphWindow->redraw();
+		return;
 	}
+	__gVtxCount = __vertices._count;
+	fitView();
+	// build the distance oracle and the neighbour lists once for this city set, shared by every solver run on it
+	//
+	__distOracle.build(__vertices);
+	__neighbours.build(__vertices, __Neighbour_Count);
 	// write info
 	//
+	infoBarBrowser->add("------------------------------");
 	char infoStr[32];
-	sprintf_s(infoStr, 32, "%d %s", __toursPopulationCount, "chromosomes made");
+	sprintf_s(infoStr, 32, "%d %s", __gVtxCount, "cities loaded..");
 	infoBarBrowser->add(infoStr);
 	infoBarBrowser->bottomline(infoBarBrowser->size());
-	mainWindow->redraw();
-}
-
-
-
-// function to sort the tours in the current population based on fitnesses, i.e. the length of the tour,
-// resort __toursPopulationList based on insertion sort method
-//
-void sortTours() {
-	GPath *tour = NULL;
-	int j;
-	for (int i = 1; i < __toursPopulationCount; i++) {
-		tour = __toursPopulationList[i];
-		j = i - 1;
-		while (j >= 0 && tour->_length < __toursPopulationList[j]->_length) {
-			__toursPopulationList[j + 1] = __toursPopulationList[j--];
-		}
-		__toursPopulationList[j + 1] = tour;
-	}
+	graphWindow->redraw();
 }
 
 
-void merge(GPath **A, unsigned l, unsigned m, unsigned u) {
-	GPath **B = new GPath *[u - l + 1];
-	unsigned h = l;
-	unsigned k = m + 1;
-	unsigned j = 0;
-	while (h <= m  &&  k <= u) {
-		if (A[h]->_length < A[k]->_length)
-			B[j++] = A[h++];
-		else
-			B[j++] = A[k++];
-	}	
-	if (h > m)	for (unsigned r = k; r <= u; B[j++] = A[r++]);
-	else		for (unsigned r = h; r <= m; B[j++] = A[r++]);
-	for (unsigned r = l; r <= u; A[r++] = B[r - l]);
-	delete []B;
-}
-void mergeSort(GPath **A, unsigned l, unsigned u) {
-	if (l < u){
-		unsigned m = (l + u) / 2;
-		mergeSort(A, l, m);
-		mergeSort(A, m + 1, u);
-		merge(A, l, m, u);
-	}
-}
-
 
-// function to select, return true, based on the given probability value, between 0.0 and 1.0,
-// return false otherswise
+// progress call back of the solver, on the GA thread, only counts the generations,
+// the UI thread pulls the progress and the best tour itself, so the GA never waits for the drawing
 //
-bool selectByProbability(float p) {
-	float r = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-	if (r < p)
-		return true;
-	else
-		return false;
+void solverProgress(const TSPSolver *, int generation, bool, void *) {
+	__generationDone.store(generation + 1, std::memory_order_relaxed);
 }
 
 
-
-// search the given input in the given list to find the index associated to
-// return index if it exists, return -1 otherswise, if every thing went right this always return an index
+// function to pull the latest best tour and progress of the solver on the UI thread,
+// write and draw the best tour if it was published since the last pull
 //
-int searchIdx(const GPath *path, const int x) {
-	for (int i = 0; i < __gVtxCount; i++) {
-		if (path->_path[i]._vid == x) {
-			return i;
-		}
+void pullProgress() {
+	const GTourSnapshot *tour = __bestTours.latest();
+	if (tour->_serial && tour->_serial != __shownSerial) {
+		__shownTour = tour;
+		__shownSerial = tour->_serial;
+		writeInfo(tour->_length);
+		graphWindow->redraw();
 	}
-	return -1;
+	progressBar->value(float(__generationDone.load(std::memory_order_relaxed)) / __generationIter);
 }
 
-
-
-// function to operation mutation on the given chromosome,
+// timer call back of the UI thread, pulls the progress at the frame rate while computing
 //
-void mutate(GPath *tour) {
-	// select to random indicex, r1 and r2
-	//
-	int r1 = rand() % __gVtxCount;
-	int r2 = rand() % __gVtxCount;
-	// guarantee the r1 and r2 are not equal
-	//
-	while (r1 == r2)
-		r2 = rand() % __gVtxCount;
-	// swap the two randomly selected genes
-	//
-	GEdgeVertex vtx = tour->_path[r1];
-	tour->_path[r1] = tour->_path[r2];
-	tour->_path[r2] = vtx;
-	// update the mutated chromosome length
-	//
-	tour->updateLength();
+void progressTimer(void *) {
+	pullProgress();
+	Fl::repeat_timeout(__Frame_Seconds, progressTimer);
 }
 
-
-
-// function to select survivors based on the rank-based selection ,method by the probability of (i/n)
-// return the index of the last survivor + 1, i.e. the index of the first looser
+// awake call back, run on the UI thread when the GA thread completed or was stopped,
+// the last best tour is pulled and the UI activated again
 //
-int selectSurvivors() {
-	// first sort the population, so the best fitted choromosomes are on the top
-	//
-	sortTours();
-	//mergeSort(__toursPopulationList, 0, __toursPopulationCount - 1);
-	int k = 0;
-	// iterate through all the chromosomes to select the survivors based on the rank-based probability, i.e. (i/n)
-	//
-	for (int i = 0; i < __toursPopulationCount; i++) {
-		// if this chromosome survived, pass on it and just increment k by one
-		//
-		if (selectByProbability(1.0f - (float)i / __toursPopulationCount)) {
-			k++;
-		}
-		// if this choromosome failed, set its tour length to infinity
-		//
-		else {
-			__toursPopulationList[i]->_length = __INF_LEN_TOUR__;
-		}
-	}
-	// resort the population list to bring the survivors up and the loosers down
-	//
-	sortTours();
-	//mergeSort(__toursPopulationList, 0, __toursPopulationCount - 1);
-//	SYSTEMTIME st;
-//	GetSystemTime(&st);
-//	cout << st.wSecond << endl;
-	// now k is the index of the last survivor + 1, i.e. the index of the first looser
-	//
-	return k;		
+void computationDone(void *) {
+	Fl::remove_timeout(progressTimer);
+	pullProgress();
+	if (!__solver->result()._stopped)
+		progressBar->value(1.0f);
+	activateUI();
 }
 
 
 
-// function to Cycle crossover, CX, of two parents,
-// return the two children if returnTwo if set to true, otherwise return one child,
+// core function of the GA thread, runs the solver made by the UI thread, and wakes the UI thread when done,
+// it never touches a widget, the UI thread pulls the progress itself
 //
-void CX_crossover(const GPath *parent1, const GPath *parent2, GPath **child1, GPath **child2, bool returnTwo) {
-	int k, h = 0;
-	// iterate through the parents genes to check the equality of their genes
-	//
-	while (parent1->_path[h]._vid == parent2->_path[h++]._vid) {
-		// check if h is not overflow
-		// if so, break the iteration
-		//
-		if (h >= __gVtxCount) {
-			h--;	// now h is the index of the first inequal gene of the parent chromosomes
-			break;
-		}
-	}
-	// generate child 1
-	//
-	*child1 = new GPath();
-	(*child1)->_path = new GEdgeVertex[__gVtxCount];
-	(*child1)->_path[h] = parent1->_path[h];
-	// set k to h, so CX starts from h-th index, the first inequal gene
-	//
-	k = h;	
-	// start mapping from k, the first inequal gene
-	//
-	k = searchIdx(parent1, parent2->_path[k]._vid);
-	// start iteration with the condidtion of cycle check,
-	// and assign the genes to the child1 by cyclically mapping the common city Ids
-	//
-	while (k != h) {
-		(*child1)->_path[k] = parent1->_path[k];
-		k = searchIdx(parent1, parent2->_path[k]._vid);
-	}
-	// fill blank gens based on the id of the cities, if it is -1 so it is empty, otherwise is set already
-	//
-	for (int i = 0; i < __gVtxCount; i++) {
-		if ((*child1)->_path[i]._vid == -1)
-			(*child1)->_path[i] = parent2->_path[i];
-	}
-	// update child1 tour length
-	//
-	(*child1)->updateLength();
-	// check if returnTwo is set to true to generate the second child
-	//
-	if (returnTwo) {
-		// generate child 2
-		//
-		*child2 = new GPath();
-		(*child2)->_path = new GEdgeVertex[__gVtxCount];
-		(*child2)->_path[h] = parent2->_path[h];
-		k = h;
-		k = searchIdx(parent2, parent1->_path[k]._vid);
-		while (k != h) {
-			(*child2)->_path[k] = parent2->_path[k];
-			k = searchIdx(parent2, parent1->_path[k]._vid);
-		}
-		// fill blank gens
-		//
-		for (int i = 0; i < __gVtxCount; i++) {
-			if ((*child2)->_path[i]._vid == -1)
-				(*child2)->_path[i] = parent1->_path[i];
-		}
-		// update child2 tour length
-		//
-		(*child2)->updateLength();
-	}
+void *TSP_GA_CX(void *) {
+	__solver->solve();
+	Fl::awake(computationDone, NULL);
+	return 0;
 }
 
 
 
-// core function to compute TSP using GA based on CX crossover and rank-based selection
+// call back function to run TSP_GA_CX,
+// read the GA parameters from the UI and make the solver on the UI thread, then run it on the GA thread
 //
-void *TSP_GA_CX(void *) {
+void TSP_GA_Cx(Fl_Widget *, void *) {
 	// check if cities are generated
 	//
-	if (!__GVerices)
-		return 0;
-	// deactivate the UI, set stop condidtion to false, update seed, read gen Iter and mutation from UI
+	if (!__vertices._count)
+		return;
+	// deactivate the UI, read gen Iter, chromosomes and mutation from UI
 	//
 	deactivateUI();
-	__stopComputing = false;
-	srand(clock());
 	__generationIter = (int)generationIterSlider->value();
+	__toursPopulationCount = (int)populationCountSlider->value();
 	__mutationProb = (float)mutationPercentSlider->value() / 100.0f;
-	// initiate random population 
-	//
-	initiatePopulation();
-	// set the default best tour to the first initial chromosome
-	//
-	__bestTour = __toursPopulationList[0];
+	TSPConfig config;
+	config._generationIter = __generationIter;
+	config._populationCount = __toursPopulationCount;
+	config._mutationProb = __mutationProb;
+	config._threadCount = 0;
+	config._localSearch = localSearchCheck->value() ? TSP_LS_CHILDREN : TSP_LS_NONE;
+	config._neighbourCount = __Neighbour_Count;
+	// drop the previous solver and its best tour, and make a new one for the current cities,
+	// the GA thread of the previous solver is done, the UI is only activated again by computationDone()
+	//
+	delete __solver;
+	__shownTour = NULL;
+	__shownSerial = 0;
+	__bestTours.allocate(__gVtxCount);
+	__generationDone.store(0);
+	__solver = TSPSolver::create(__vertices, config, &__distOracle, &__neighbours);
+	__solver->callback(solverProgress, NULL);
+	__solver->publisher(&__bestTours);
 	// write header info and update drawing
 	//
+	char infoStr[32];
+	sprintf_s(infoStr, 32, "%d %s", __toursPopulationCount, "chromosomes made");
+	infoBarBrowser->add(infoStr);
 	writeHeaderInfo();
 	graphWindow->redraw();
-	// select the first list of survivors
-	//
-	int k = selectSurvivors();
-	// iterates to generate the generations of populations
-	//
-	for (int i = 0; i < __generationIter; i++) {
-		// iterate through the current population list from k-th index, i.e. the index of the first looser, to replace the newly made children
-		//
-		while (k < __toursPopulationCount) {
-			// generate random p1 and p2
-			//
-			int p1 = rand() % k;
-			int p2 = rand() % k;
-			// guarantee p1 and p2 are not equal
-			//
-			while (p1 == p2)
-				p2 = rand() % k;
-			// delete the k-th chromosome and make the child1 ready to be replaced with
-			//
-			delete[] __toursPopulationList[k]->_path;
-			delete __toursPopulationList[k];
-			GPath *child1 = NULL;
-			k++;
-			// after incrementing k, check if k is still inside the population
-			// if so, two childern generated and replaced
-			//
-			if (k < __toursPopulationCount) {
-				// delete the (k+1)-th chromosome and make the child1 ready to be replaced with 
-				// notice the k was already incemented by 1
-				//
-				delete[] __toursPopulationList[k]->_path;
-				delete __toursPopulationList[k];
-				GPath *child2 = NULL;
-				// operate CX cross over on p1 and p2 chromosomes to generate child1 and child2
-				//
-				CX_crossover(__toursPopulationList[p1], __toursPopulationList[p2], &child1, &child2, true);
-				// now child1 and child2 are made
-				// mutate the child1 based on the given probability and replace it with the old one
-				//
-				if (__mutationProb != 0.0f  &&  selectByProbability(__mutationProb))
-					mutate(child1);
-				__toursPopulationList[k - 1] = child1;
-				// mutate the child2 based on the given probability and replace it with the old one
-				//
-				if (__mutationProb != 0.0f  &&  selectByProbability(__mutationProb))
-					mutate(child2);
-				__toursPopulationList[k] = child2;
-				k++;
-			}
-			// (k < __toursPopulationCount), otherwise k is out of the population,
-			// so just one child is made
-			//
-			else {
-				// operate CX cross over on p1 and p2 chromosomes to generate child1
-				//
-				CX_crossover(__toursPopulationList[p1], __toursPopulationList[p2], &child1, NULL, false);
-				// now child1 is made
-				// mutate the child1 based on the given probability and replace it with the old one
-				//
-				if (__mutationProb != 0.0f  &&  selectByProbability(__mutationProb))
-					mutate(child1);
-				__toursPopulationList[k - 1] = child1;
-			}
-			// check if the stop computing button is pressed
-			// if so, terminate the computation
-			//
-			if (__stopComputing) {
-				return 0;
-			}
-		}
-		// select new survivors from the newly set population
-		//
-		k = selectSurvivors();
-		// set the best solution by checking if there is the better best tour
-		// as the best tour in each generation is the first tour after sorting, so the best tour is compared with the first tour of each generation
-		//
-		if (__toursPopulationList[0]->_length < __bestTour->_length) {
-			__bestTour = __toursPopulationList[0];
-			writeInfo(__bestTour);
-			graphWindow->redraw();
-		}
-		// update the progress bar
-		//
-		progressBar->value(float(i) / __generationIter);
-	}
-	// activate the UI after terminating the iteration
-	//
-	progressBar->value(1.0f);
-	activateUI();
-	return 0;
-}
-
-
-
-// call back function to run TSP_GA_CX
-//
-void TSP_GA_Cx(Fl_Widget *, void *) {
 	// create a thread for TSP_GA_CX procedure to prevent the graph window from being locked.
 	// so the graph window and other UI elements become updated interactively while computing
 	//
+	Fl::add_timeout(__Frame_Seconds, progressTimer);
 	fl_create_thread(GA_thread, TSP_GA_CX, (void *)0);
 }
 
 
-// call back function to stop computing by pressing Stop Computing
-// just set __stopComputing to true and activate UI elements
+// call back function to stop computing by pressing Stop Computing,
+// just stop the solver, the UI elements are activated by computationDone() once the GA thread returns
 //
 void stopComputing(Fl_Widget *, void *) {
-	__stopComputing = true;
-	activateUI();
+	if (__solver)
+		__solver->stop();
 }
 
 
@@ -678,9 +454,12 @@ void makeMainWindow(const char *) {
 	verticesCountSlider->bounds(2, 50);
 	verticesCountSlider->value(2);
 
-	graphGenButton = new Fl_Button(__Ctrl_Col, __Ctrl_row, 180, 20, "Generate Cities");	__Ctrl_row += __Ctrl_row_delta + 25;
+	graphGenButton = new Fl_Button(__Ctrl_Col, __Ctrl_row, 180, 20, "Generate Cities");	__Ctrl_row += __Ctrl_row_delta;
 	graphGenButton->callback(generateCities);
 
+	graphLoadButton = new Fl_Button(__Ctrl_Col, __Ctrl_row, 180, 20, "Load TSPLIB");	__Ctrl_row += __Ctrl_row_delta + 25;
+	graphLoadButton->callback(loadCities);
+
 	sliders[1] = generationIterSlider = new Fl_Value_Slider(__Ctrl_Col, __Ctrl_row, 180, 20, "Generaton");	__Ctrl_row += __Ctrl_row_delta;
 	generationIterSlider->bounds(1, 5000);
 	generationIterSlider->value(1);
@@ -692,6 +471,8 @@ void makeMainWindow(const char *) {
 	sliders[3] = mutationPercentSlider = new Fl_Value_Slider(__Ctrl_Col, __Ctrl_row, 180, 20, "Mutation%");	__Ctrl_row += __Ctrl_row_delta + 10;
 	mutationPercentSlider->bounds(0, 100);
 
+	localSearchCheck = new Fl_Check_Button(__Ctrl_Col, __Ctrl_row, 180, 20, "Local search (2-opt)");	__Ctrl_row += __Ctrl_row_delta + 10;
+
 	computeTSPButton = new Fl_Button(__Ctrl_Col, __Ctrl_row, 180, 20, "Compute TSP");		__Ctrl_row += __Ctrl_row_delta + 10;
 	computeTSPButton->callback(TSP_GA_Cx);
 
@@ -730,4 +511,4 @@ void makeMainWindow(const char *) {
 
 
 
-#endif /*__TSPGA_H__*/
\ No newline at end of file
+#endif /*__TSPGA_H__*/
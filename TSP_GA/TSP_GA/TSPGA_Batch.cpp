@@ -0,0 +1,254 @@
+// batch front end of the TSP solver,
+// solves a stream of instances in one process, each on its own thread of a work stealing pool,
+// and writes a result line as every instance ends, in completion order
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <chrono>
+
+#include "Batch.h"
+#include "TSPLIB.h"
+
+#define __BATCH_Area_W 900		// width of the area the random cities are placed in
+#define __BATCH_Area_H 600		// height of the area the random cities are placed in
+#define __BATCH_NAME_SIZE 256	// longest instance name of the input, longer names are cut
+#define __BATCH_FIRST_VTX 1024	// positions the buffers of an instance hold before they grow with the positions read
+
+
+// print the command line usage
+//
+void usage(const char *prog) {
+	fprintf(stderr,
+		"usage: %s [options]\n"
+		"  -f <file>     read the instances from the given file, - is the standard input (default -)\n"
+		"  -r <count>    solve the given count of random instances instead of reading any\n"
+		"  -c <count>    cities count of the random instances (default 50)\n"
+		"  -j <count>    instances solved at once, one per thread, 0 uses every hardware thread (default 0)\n"
+		"  -g <count>    generation iteration count, 0 runs until another limit (default 1000)\n"
+		"  -p <count>    chromosomes count in each generation (default 1000)\n"
+		"  -m <percent>  mutation percentage (default 1)\n"
+		"  -s <seed>     random seed of every instance, 0 seeds from the clock (default 0)\n"
+		"  -x <name>     crossover operator, cx, ox, pmx, erx or eax (default cx)\n"
+		"  -P <name>     parent selection among the survivors, uniform, tournament, rank or fitness (default uniform)\n"
+		"  -z <count>    survivors drawn by every tournament of -P tournament (default 2)\n"
+		"  -u            keep the tours of the population distinct, and reuse the lengths of the tours seen before\n"
+		"  -b            keep the tours of the population bit packed, for the populations outgrowing the memory\n"
+		"  -l            improve every child by 2-opt and Or-opt local search, the memetic mode\n"
+		"  -N <count>    nearest neighbours of every city, the candidates of local search and eax, 0 builds none (default 8)\n"
+		"  -L <seconds>  stop every instance after the given wall clock seconds\n"
+		"  -S <count>    stop every instance after the given generations without improvement of the best tour\n"
+		"  -X <length>   stop every instance once the best tour is not longer than the given length\n"
+		"  -t            write the best tour city ids of every instance\n"
+		"\n"
+		"an instance of the input is a name followed by its cities count and the x y positions of its cities,\n"
+		"or by @ and the path of a TSPLIB .tsp file, separated by white space, an instance of less than 2 cities is skipped.\n"
+		"every solved instance writes the line: name cities length generations seconds [tour]\n", prog);
+}
+
+
+TSPBatch *__batch = NULL;		// running batch, stopped by SIGINT and SIGTERM
+
+
+// signal handler, stop the batch so the running instances write their best tours so far
+//
+void stopBatch(int) {
+	if (__batch)
+		__batch->stop();
+}
+
+
+// result call back, write the line of a solved instance, the call backs never overlap
+//
+void batchResult(const TSPBatchResult &result, void *data) {
+	bool writeTour = *(bool *)data;
+	const TSPResult &r = *result._result;
+	printf("%s %d %.2f %d %.3f", result._name, result._vtxCount, r._bestTour->_length, r._generations, r._seconds);
+	if (writeTour)
+		for (int i = 0; i < result._vtxCount; i++)
+			printf(" %u", r._bestTour->_path[i]);
+	printf("\n");
+	fflush(stdout);
+}
+
+
+// read the next instance of the input into the vertex store, return false at the end of the input or on an error,
+// which also sets bad
+//
+bool readInstance(FILE *in, char *name, GVertexStore &vertices, bool &bad) {
+	char count[__BATCH_NAME_SIZE];
+	char format[16];
+	sprintf(format, "%%%ds", __BATCH_NAME_SIZE - 1);
+	if (fscanf(in, format, name) != 1)
+		return false;
+	if (fscanf(in, format, count) != 1) {
+		fprintf(stderr, "%s: missing cities\n", name);
+		bad = true;
+		return false;
+	}
+	if (count[0] == '@') {
+		const char *error;
+		if (!loadTSPLIB(count + 1, vertices, &error)) {
+			fprintf(stderr, "%s: %s\n", count + 1, error);
+			bad = true;
+			return false;
+		}
+		return true;
+	}
+	// an instance of less than 2 cities is read but has no tour, submit() skips it
+	//
+	char *end;
+	long vtxCount = strtol(count, &end, 10);
+	if (*end || vtxCount < 0 || vtxCount > 0x7FFFFFFF) {
+		fprintf(stderr, "%s: bad cities count\n", name);
+		bad = true;
+		return false;
+	}
+	if (vtxCount < 2)
+		fprintf(stderr, "%s: skipped, less than 2 cities\n", name);
+	// the positions are read into buffers doubled as they fill, so a count the input does not hold
+	// ends on its first missing position instead of allocating the whole count up front
+	//
+	int capacity = vtxCount < __BATCH_FIRST_VTX ? (int)vtxCount : __BATCH_FIRST_VTX;
+	float *x = new float[capacity];
+	float *y = new float[capacity];
+	bool ok = true;
+	for (int i = 0; ok && i < vtxCount; i++) {
+		if (i == capacity) {
+			capacity = vtxCount - capacity < capacity ? (int)vtxCount : 2 * capacity;
+			float *grownX = new float[capacity];
+			float *grownY = new float[capacity];
+			memcpy(grownX, x, i * sizeof(float));
+			memcpy(grownY, y, i * sizeof(float));
+			delete[] x;
+			delete[] y;
+			x = grownX;
+			y = grownY;
+		}
+		if (fscanf(in, "%f %f", &x[i], &y[i]) != 2) {
+			fprintf(stderr, "%s: missing position of city %d\n", name, i);
+			ok = false;
+			bad = true;
+		}
+	}
+	if (ok) {
+		vertices.resize((int)vtxCount);
+		memcpy(vertices._x, x, vtxCount * sizeof(float));
+		memcpy(vertices._y, y, vtxCount * sizeof(float));
+	}
+	delete[] x;
+	delete[] y;
+	return ok;
+}
+
+
+int main(int argc, char **argv) {
+	const char *inputFile = "-";
+	int randomCount = 0;
+	int vtxCount = 50;
+	int threadCount = 0;
+	bool writeTour = false;
+	TSPConfig config;
+	config._generationIter = 1000;
+	config._populationCount = 1000;
+	config._mutationProb = 0.01f;
+	// read the options
+	//
+	for (int i = 1; i < argc; i++) {
+		const char *opt = argv[i];
+		if (!strcmp(opt, "-t"))
+			writeTour = true;
+		else if (!strcmp(opt, "-l"))
+			config._localSearch = TSP_LS_CHILDREN;
+		else if (!strcmp(opt, "-u"))
+			config._uniqueTours = true;
+		else if (!strcmp(opt, "-b"))
+			config._packedTours = true;
+		else if (i + 1 < argc && !strcmp(opt, "-f"))
+			inputFile = argv[++i];
+		else if (i + 1 < argc && !strcmp(opt, "-r"))
+			randomCount = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-c"))
+			vtxCount = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-j"))
+			threadCount = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-g"))
+			config._generationIter = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-p"))
+			config._populationCount = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-m"))
+			config._mutationProb = (float)atof(argv[++i]) / 100.0f;
+		else if (i + 1 < argc && !strcmp(opt, "-s"))
+			config._seed = (unsigned)strtoul(argv[++i], NULL, 10);
+		else if (i + 1 < argc && !strcmp(opt, "-L"))
+			config._timeLimit = atof(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-S"))
+			config._stallGenerations = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-X"))
+			config._targetLength = (float)atof(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-x") && crossoverByName(argv[i + 1], config._crossover))
+			i++;
+		else if (i + 1 < argc && !strcmp(opt, "-P") && selectionByName(argv[i + 1], config._selection))
+			i++;
+		else if (i + 1 < argc && !strcmp(opt, "-z"))
+			config._tournamentSize = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-N"))
+			config._neighbourCount = atoi(argv[++i]);
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (randomCount < 0 || vtxCount < 2 || threadCount < 0 || config._populationCount < 2 || config._generationIter < 0
+		|| config._timeLimit < 0.0 || config._stallGenerations < 0 || config._targetLength < 0.0f || config._tournamentSize < 1
+		|| config._neighbourCount < 0) {
+		usage(argv[0]);
+		return 1;
+	}
+	FILE *in = NULL;
+	if (!randomCount) {
+		in = strcmp(inputFile, "-") ? fopen(inputFile, "r") : stdin;
+		if (!in) {
+			fprintf(stderr, "%s: can not open the file\n", inputFile);
+			return 1;
+		}
+	}
+	// feed the instances to the batch as they are read, submit() blocks while the pool is full,
+	// so a long input is never held in memory
+	//
+	TSPBatch batch(config, threadCount);
+	batch.callback(batchResult, &writeTour);
+	__batch = &batch;
+	signal(SIGINT, stopBatch);
+	signal(SIGTERM, stopBatch);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	GVertexStore vertices;
+	char name[__BATCH_NAME_SIZE];
+	bool failed = false, bad = false;
+	if (randomCount) {
+		GRandom rng(config._seed);
+		for (int i = 0; i < randomCount && !batch.stopped(); i++) {
+			sprintf(name, "random%d", i);
+			randomVertices(vertices, vtxCount, __BATCH_Area_W, __BATCH_Area_H, rng);
+			batch.submit(name, vertices);
+		}
+	}
+	else {
+		while (!batch.stopped() && readInstance(in, name, vertices, bad))
+			batch.submit(name, vertices);
+		failed = !batch.stopped() && (bad || !feof(in));
+		if (in != stdin)
+			fclose(in);
+	}
+	batch.finish();
+	__batch = NULL;
+	// write the throughput
+	//
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	fprintf(stderr, "instances: %lld\n", batch.solved());
+	fprintf(stderr, "threads: %d\n", batch.threadCount());
+	fprintf(stderr, "seconds: %.3f\n", seconds);
+	fprintf(stderr, "instances/s: %.2f\n", seconds > 0.0 ? batch.solved() / seconds : 0.0);
+	return failed ? 1 : 0;
+}
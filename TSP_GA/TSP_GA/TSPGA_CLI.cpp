@@ -0,0 +1,290 @@
+// command line front end of the TSP solver,
+// runs the GA on random cities or a TSPLIB instance without any window, so it is usable on headless machines
+//
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+
+#include "TSPSolver.h"
+#include "TSPLIB.h"
+
+#define __CLI_Area_W 900	// width of the area the random cities are placed in
+#define __CLI_Area_H 600	// height of the area the random cities are placed in
+
+
+// print the command line usage
+//
+void usage(const char *prog) {
+	fprintf(stderr,
+		"usage: %s [options]\n"
+		"  -c <count>    cities count of the random cities (default 50)\n"
+		"  -f <file>     load the cities of a TSPLIB .tsp file instead of random cities\n"
+		"  -o <file>     compare the best tour with the tour of a TSPLIB .opt.tour file\n"
+		"  -g <count>    generation iteration count, 0 runs until another limit or an interrupt (default 1000)\n"
+		"  -p <count>    chromosomes count in each generation (default 1000)\n"
+		"  -m <percent>  mutation percentage (default 1)\n"
+		"  -s <seed>     random seed, 0 seeds from the clock (default 0)\n"
+		"  -j <count>    worker threads, 0 uses every hardware thread (default 1)\n"
+		"  -i <count>    islands count, more than one runs the island model (default 1)\n"
+		"  -k <count>    generations between two migrations of the islands, 0 never migrates (default 50)\n"
+		"  -n <count>    best tours sent by an island in every migration (default 2)\n"
+		"  -r            send the migrants to a random island instead of the next one of the ring\n"
+		"  -x <name>     crossover operator, cx, ox, pmx, erx or eax (default cx)\n"
+		"  -P <name>     parent selection among the survivors, uniform, tournament, rank or fitness (default uniform)\n"
+		"  -z <count>    survivors drawn by every tournament of -P tournament (default 2)\n"
+		"  -u            keep the tours of the population distinct, and reuse the lengths of the tours seen before\n"
+		"  -b            keep the tours of the population bit packed, for the populations outgrowing the memory\n"
+		"  -l            improve every child by 2-opt and Or-opt local search, the memetic mode\n"
+		"  -e <count>    improve the given count of best tours of every generation by local search instead\n"
+		"  -N <count>    nearest neighbours of every city, the candidates of local search, eax, -M and -G, 0 builds none (default 8)\n"
+		"  -M            mutate by joining a random city to one of its -N nearest neighbours instead of swapping two random cities\n"
+		"  -G <count>    initial tours built by nearest neighbour from random cities, needs -N (default 0)\n"
+		"  -C <file>     write checkpoints of the run to the given file, and one when the run is interrupted\n"
+		"  -K <count>    generations between two checkpoints, 0 only writes one when interrupted (default 100)\n"
+		"  -R            resume from the -C file if it exists, with its cities and parameters but the -g, -j, -K, -L, -S and -X options\n"
+		"  -L <seconds>  stop the run after the given wall clock seconds\n"
+		"  -S <count>    stop the run after the given generations without improvement of the best tour\n"
+		"  -X <length>   stop the run once the best tour is not longer than the given length\n"
+		"  -T <file>     write a record of every generation to the given file, - is the standard output\n"
+		"  -F <format>   format of the -T records, json lines or csv (default json)\n"
+		"  -v            write every improvement of the best tour\n"
+		"  -t            write the best tour city ids\n", prog);
+}
+
+
+TSPSolver *__solver = NULL;		// running solver, stopped by SIGINT and SIGTERM
+
+
+// signal handler, stop the solver so it writes its checkpoint and the best tour so far
+//
+void stopSolver(int) {
+	if (__solver)
+		__solver->stop();
+}
+
+
+// progress call back, write every improvement of the best tour
+//
+void cliProgress(const TSPSolver *solver, int generation, bool improved, void *) {
+	if (improved)
+		printf("generation %d: %.2f\n", generation, solver->bestTour()->_length);
+}
+
+
+int main(int argc, char **argv) {
+	int vtxCount = 50;
+	const char *tspFile = NULL;
+	const char *tourFile = NULL;
+	bool verbose = false;
+	bool writeTour = false;
+	bool resume = false;
+	const char *telemetryFile = NULL;
+	TSPTelemetryFormat telemetryFormat = TSP_TELEMETRY_JSON;
+	TSPConfig config;
+	config._generationIter = 1000;
+	config._populationCount = 1000;
+	config._mutationProb = 0.01f;
+	config._checkpointInterval = 100;
+	// read the options
+	//
+	for (int i = 1; i < argc; i++) {
+		const char *opt = argv[i];
+		if (!strcmp(opt, "-v"))
+			verbose = true;
+		else if (!strcmp(opt, "-t"))
+			writeTour = true;
+		else if (!strcmp(opt, "-r"))
+			config._migrationTopology = TSP_MIGRATE_RANDOM;
+		else if (!strcmp(opt, "-R"))
+			resume = true;
+		else if (!strcmp(opt, "-l"))
+			config._localSearch = TSP_LS_CHILDREN;
+		else if (!strcmp(opt, "-u"))
+			config._uniqueTours = true;
+		else if (!strcmp(opt, "-b"))
+			config._packedTours = true;
+		else if (!strcmp(opt, "-M"))
+			config._neighbourMutation = true;
+		else if (i + 1 < argc && !strcmp(opt, "-c"))
+			vtxCount = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-f"))
+			tspFile = argv[++i];
+		else if (i + 1 < argc && !strcmp(opt, "-o"))
+			tourFile = argv[++i];
+		else if (i + 1 < argc && !strcmp(opt, "-g"))
+			config._generationIter = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-p"))
+			config._populationCount = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-m"))
+			config._mutationProb = (float)atof(argv[++i]) / 100.0f;
+		else if (i + 1 < argc && !strcmp(opt, "-s"))
+			config._seed = (unsigned)strtoul(argv[++i], NULL, 10);
+		else if (i + 1 < argc && !strcmp(opt, "-j"))
+			config._threadCount = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-i"))
+			config._islandCount = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-k"))
+			config._migrationInterval = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-n"))
+			config._migrantCount = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-N"))
+			config._neighbourCount = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-G"))
+			config._greedyCount = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-C"))
+			config._checkpointPath = argv[++i];
+		else if (i + 1 < argc && !strcmp(opt, "-K"))
+			config._checkpointInterval = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-L"))
+			config._timeLimit = atof(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-S"))
+			config._stallGenerations = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-X"))
+			config._targetLength = (float)atof(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-x") && crossoverByName(argv[i + 1], config._crossover))
+			i++;
+		else if (i + 1 < argc && !strcmp(opt, "-P") && selectionByName(argv[i + 1], config._selection))
+			i++;
+		else if (i + 1 < argc && !strcmp(opt, "-z"))
+			config._tournamentSize = atoi(argv[++i]);
+		else if (i + 1 < argc && !strcmp(opt, "-T"))
+			telemetryFile = argv[++i];
+		else if (i + 1 < argc && !strcmp(opt, "-F") && (!strcmp(argv[i + 1], "json") || !strcmp(argv[i + 1], "csv")))
+			telemetryFormat = !strcmp(argv[++i], "csv") ? TSP_TELEMETRY_CSV : TSP_TELEMETRY_JSON;
+		else if (i + 1 < argc && !strcmp(opt, "-e")) {
+			config._localSearch = TSP_LS_ELITE;
+			config._eliteCount = atoi(argv[++i]);
+		}
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (vtxCount < 2 || config._populationCount < 2 || config._generationIter < 0 || config._threadCount < 0
+		|| config._islandCount < 1 || config._migrationInterval < 0 || config._migrantCount < 1
+		|| config._eliteCount < 1 || config._neighbourCount < 0 || config._greedyCount < 0 || ((config._greedyCount > 0 || config._neighbourMutation) && !config._neighbourCount) || config._checkpointInterval < 0
+		|| config._timeLimit < 0.0 || config._stallGenerations < 0 || config._targetLength < 0.0f || config._tournamentSize < 1
+		|| (resume && !config._checkpointPath)) {
+		usage(argv[0]);
+		return 1;
+	}
+	// resume from the checkpoint if there is one, its cities and parameters replace those of the options,
+	// the run length, the threads and the checkpoint options are kept, so the same command line continues an interrupted run
+	//
+	GVertexStore vertices;
+	FILE *checkpoint = resume ? fopen(config._checkpointPath, "rb") : NULL;
+	if (checkpoint) {
+		fclose(checkpoint);
+		TSPConfig options = config;
+		const char *error;
+		if (!TSPSolver::readCheckpoint(config._checkpointPath, vertices, config, &error)) {
+			fprintf(stderr, "%s: %s\n", options._checkpointPath, error);
+			return 1;
+		}
+		config._generationIter = options._generationIter;
+		config._threadCount = options._threadCount;
+		config._checkpointPath = options._checkpointPath;
+		config._checkpointInterval = options._checkpointInterval;
+		config._timeLimit = options._timeLimit;
+		config._stallGenerations = options._stallGenerations;
+		config._targetLength = options._targetLength;
+		vtxCount = vertices._count;
+	}
+	// load the cities of the TSPLIB file or generate the random cities
+	//
+	else if (tspFile) {
+		const char *error;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (!loadTSPLIB(tspFile, vertices, &error)) {
+			fprintf(stderr, "%s: %s\n", tspFile, error);
+			return 1;
+		}
+		vtxCount = vertices._count;
+		printf("instance: %s\n", tspFile);
+		printf("load seconds: %.3f\n", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+	else {
+		GRandom rng(config._seed);
+		randomVertices(vertices, vtxCount, __CLI_Area_W, __CLI_Area_H, rng);
+	}
+	// load the optimal tour to compare with
+	//
+	GPath<unsigned> optTour;
+	if (tourFile) {
+		const char *error;
+		optTour._path = new unsigned[vtxCount];
+		if (!loadTSPLIBTour(tourFile, vtxCount, optTour._path, &error)) {
+			fprintf(stderr, "%s: %s\n", tourFile, error);
+			delete[] optTour._path;
+			return 1;
+		}
+	}
+	// run the solver
+	//
+	TSPSolver *solver = TSPSolver::create(vertices, config);
+	if (verbose)
+		solver->callback(cliProgress, NULL);
+	TSPTelemetry telemetry;
+	if (telemetryFile) {
+		if (!telemetry.open(telemetryFile, telemetryFormat)) {
+			fprintf(stderr, "%s: can not open the telemetry file\n", telemetryFile);
+			delete solver;
+			return 1;
+		}
+		solver->telemetry(&telemetry);
+	}
+	if (checkpoint) {
+		const char *error;
+		if (!solver->resume(config._checkpointPath, &error)) {
+			fprintf(stderr, "%s: %s\n", config._checkpointPath, error);
+			delete solver;
+			return 1;
+		}
+		printf("resumed: %s\n", config._checkpointPath);
+	}
+	__solver = solver;
+	signal(SIGINT, stopSolver);
+	signal(SIGTERM, stopSolver);
+	const TSPResult &result = solver->solve();
+	__solver = NULL;
+	// write the result
+	//
+	printf("cities: %d\n", vtxCount);
+	printf("generations: %d\n", result._generations);
+	printf("chromosomes: %d\n", config._populationCount);
+	printf("mutation: %.3f\n", config._mutationProb);
+	printf("crossover: %s\n", crossoverName(solver->config()._crossover));
+	printf("selection: %s", selectionName(config._selection));
+	if (config._selection == TSP_SELECT_TOURNAMENT)
+		printf(", %d survivors", config._tournamentSize);
+	printf("\n");
+	printf("threads: %d\n", config._threadCount ? config._threadCount : GThreadPool::hardwareThreads());
+	if (config._islandCount > 1)
+		printf("islands: %d, migration every %d generations\n", config._islandCount, config._migrationInterval);
+	if (config._localSearch == TSP_LS_CHILDREN)
+		printf("local search: children\n");
+	else if (config._localSearch == TSP_LS_ELITE)
+		printf("local search: %d best tours\n", config._eliteCount);
+	printf("best length: %.2f\n", result._bestTour->_length);
+	printf("seconds: %.3f\n", result._seconds);
+	static const char *stopReasons[] = { "generations", "interrupted", "time limit", "stall", "target" };
+	printf("stop reason: %s\n", stopReasons[result._stopReason]);
+	if (result._checkpointError)
+		fprintf(stderr, "%s: %s\n", config._checkpointPath, result._checkpointError);
+	if (tourFile) {
+		GDistanceOracle dist(vertices);
+		optTour.updateLength(dist);
+		printf("optimal length: %.2f\n", optTour._length);
+		printf("gap: %.2f%%\n", 100.0 * (result._bestTour->_length - optTour._length) / optTour._length);
+		delete[] optTour._path;
+	}
+	if (writeTour) {
+		printf("tour:");
+		for (int i = 0; i < vtxCount; i++)
+			printf(" %u", result._bestTour->_path[i]);
+		printf("\n");
+	}
+	delete solver;
+	return 0;
+}
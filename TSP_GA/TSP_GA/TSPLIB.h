@@ -0,0 +1,386 @@
+#ifndef __TSPLIB_H__
+#define __TSPLIB_H__
+
+
+
+#include <cstring>
+#include <cctype>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "Graph.h"
+
+#define __TSPLIB_MIN_LINE__ 6		// shortest "id x y" line of a NODE_COORD_SECTION, its newline included
+
+
+// read only memory mapping of a whole file, the parsers read the file bytes in place, nothing is copied
+//
+class GMappedFile {
+public:
+	GMappedFile() : _data(NULL), _size(0) {}
+	~GMappedFile() { close(); }
+
+	bool open(const char *path);		// map the given file, return false if it can not be mapped
+	void close();
+
+	const char *data() const { return _data; }
+	size_t size() const { return _size; }
+
+private:
+	GMappedFile(const GMappedFile &);
+	GMappedFile &operator=(const GMappedFile &);
+
+	const char *_data;			// first byte of the mapping, NULL if nothing is mapped
+	size_t _size;				// file size in bytes
+};
+
+
+#ifdef _WIN32
+
+bool GMappedFile::open(const char *path) {
+	close();
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!mapping)
+		return false;
+	_data = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!_data)
+		return false;
+	_size = (size_t)size.QuadPart;
+	return true;
+}
+
+void GMappedFile::close() {
+	if (_data)
+		UnmapViewOfFile(_data);
+	_data = NULL;
+	_size = 0;
+}
+
+#else
+
+bool GMappedFile::open(const char *path) {
+	close();
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+	void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED)
+		return false;
+	madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+	_data = (const char *)data;
+	_size = (size_t)st.st_size;
+	return true;
+}
+
+void GMappedFile::close() {
+	if (_data)
+		munmap((void *)_data, _size);
+	_data = NULL;
+	_size = 0;
+}
+
+#endif
+
+
+
+// cursor over the bytes of a mapped file, the file is not NUL terminated so every read checks the end
+//
+struct GTextCursor {
+	GTextCursor(const char *begin, const char *end) : _p(begin), _end(end) {}
+	const char *_p;				// current byte
+	const char *_end;			// end of the file
+
+	bool atEnd() const { return _p >= _end; }
+
+	void skipBlanks() {
+		while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\r'))
+			_p++;
+	}
+	void skipSpaces() {
+		while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\r' || *_p == '\n'))
+			_p++;
+	}
+	void skipLine() {
+		while (_p < _end && *_p != '\n')
+			_p++;
+		if (_p < _end)
+			_p++;
+	}
+
+	// keyword at the cursor, letters, digits and '_', returned as pointer and length into the file
+	//
+	int word(const char *&w) {
+		skipSpaces();
+		w = _p;
+		while (_p < _end && (isalnum((unsigned char)*_p) || *_p == '_'))
+			_p++;
+		return (int)(_p - w);
+	}
+
+	// integer at the cursor, return false if there is no number
+	//
+	bool integer(long long &v) {
+		skipSpaces();
+		bool neg = false;
+		if (_p < _end && (*_p == '-' || *_p == '+'))
+			neg = *_p++ == '-';
+		if (_p >= _end || *_p < '0' || *_p > '9')
+			return false;
+		v = 0;
+		while (_p < _end && *_p >= '0' && *_p <= '9')
+			v = v * 10 + (*_p++ - '0');
+		if (neg)
+			v = -v;
+		return true;
+	}
+
+	// real number at the cursor, with optional fraction and exponent, return false if there is no number
+	//
+	bool real(double &v) {
+		skipSpaces();
+		bool neg = false;
+		if (_p < _end && (*_p == '-' || *_p == '+'))
+			neg = *_p++ == '-';
+		const char *start = _p;
+		double m = 0.0;
+		while (_p < _end && *_p >= '0' && *_p <= '9')
+			m = m * 10.0 + (*_p++ - '0');
+		int exp = 0;
+		if (_p < _end && *_p == '.') {
+			_p++;
+			while (_p < _end && *_p >= '0' && *_p <= '9') {
+				m = m * 10.0 + (*_p++ - '0');
+				exp--;
+			}
+		}
+		if (_p == start || (_p == start + 1 && *start == '.'))
+			return false;
+		if (_p < _end && (*_p == 'e' || *_p == 'E')) {
+			_p++;
+			long long e;
+			if (!integer(e))
+				return false;
+			exp += (int)e;
+		}
+		v = exp ? m * pow(10.0, exp) : m;
+		if (neg)
+			v = -v;
+		return true;
+	}
+};
+
+
+// true if the keyword of the given length is the given name
+//
+bool isKeyword(const char *w, int len, const char *name) {
+	return (int)strlen(name) == len && !strncmp(w, name, len);
+}
+
+
+// read the specification part of a TSPLIB file up to the given data section,
+// every "KEY : VALUE" line is passed to the spec call back, return false if the section is not found
+//
+template <typename TSpec>
+bool readSpecification(GTextCursor &c, const char *section, TSpec &spec) {
+	while (!c.atEnd()) {
+		const char *w;
+		int len = c.word(w);
+		if (!len) {
+			c.skipLine();
+			continue;
+		}
+		if (isKeyword(w, len, section)) {
+			c.skipLine();
+			return true;
+		}
+		c.skipBlanks();
+		if (!c.atEnd() && *c._p == ':')
+			c._p++;
+		c.skipBlanks();
+		const char *value = c._p;
+		c.skipLine();
+		const char *valueEnd = c._p;
+		while (valueEnd > value && (valueEnd[-1] == '\n' || valueEnd[-1] == '\r' || valueEnd[-1] == ' ' || valueEnd[-1] == '\t'))
+			valueEnd--;
+		if (!spec(w, len, value, (int)(valueEnd - value)))
+			return false;
+	}
+	return false;
+}
+
+
+// specification fields of a TSPLIB file needed by the readers
+//
+struct TSPLIBSpec {
+	TSPLIBSpec(const char *type) : _type(type), _typeOk(false), _dimension(0), _metric(G_METRIC_EUC_2D), _metricOk(true), _error(NULL) {}
+	const char *_type;			// expected TYPE of the file
+	bool _typeOk;				// TYPE matches the expected one
+	long long _dimension;		// DIMENSION, cities count
+	GMetric _metric;			// EDGE_WEIGHT_TYPE
+	bool _metricOk;				// EDGE_WEIGHT_TYPE is supported
+	const char *_error;			// reason of a rejected field
+
+	bool operator()(const char *key, int keyLen, const char *value, int valueLen) {
+		if (isKeyword(key, keyLen, "TYPE")) {
+			int typeLen = (int)strlen(_type);
+			_typeOk = valueLen >= typeLen && !strncmp(value, _type, typeLen);
+			if (!_typeOk)
+				_error = "unsupported TYPE";
+		}
+		else if (isKeyword(key, keyLen, "DIMENSION")) {
+			GTextCursor c(value, value + valueLen);
+			if (!c.integer(_dimension) || _dimension < 2) {
+				_error = "invalid DIMENSION";
+				return false;
+			}
+		}
+		else if (isKeyword(key, keyLen, "EDGE_WEIGHT_TYPE")) {
+			_metricOk = true;
+			if (isKeyword(value, valueLen, "EUC_2D"))			_metric = G_METRIC_EUC_2D;
+			else if (isKeyword(value, valueLen, "CEIL_2D"))	_metric = G_METRIC_CEIL_2D;
+			else if (isKeyword(value, valueLen, "GEO"))		_metric = G_METRIC_GEO;
+			else if (isKeyword(value, valueLen, "ATT"))		_metric = G_METRIC_ATT;
+			else {
+				_metricOk = false;
+				_error = "unsupported EDGE_WEIGHT_TYPE";
+			}
+		}
+		return _error == NULL;
+	}
+};
+
+
+
+// function to load the cities of a TSPLIB .tsp file with a NODE_COORD_SECTION into the vertex store,
+// EUC_2D, CEIL_2D, GEO and ATT edge weight types are supported, the file is memory mapped and parsed in place,
+// return false and set error if the file can not be read
+//
+bool loadTSPLIB(const char *path, GVertexStore &vertices, const char **error) {
+	const char *dummy;
+	if (!error)
+		error = &dummy;
+	GMappedFile file;
+	if (!file.open(path)) {
+		*error = "can not open the file";
+		return false;
+	}
+	GTextCursor c(file.data(), file.data() + file.size());
+	TSPLIBSpec spec("TSP");
+	if (!readSpecification(c, "NODE_COORD_SECTION", spec)) {
+		*error = spec._error ? spec._error : "no NODE_COORD_SECTION";
+		return false;
+	}
+	if (!spec._typeOk || !spec._metricOk || spec._dimension < 2 || spec._dimension > 0x7FFFFFFF) {
+		*error = spec._error ? spec._error : !spec._typeOk ? "not a TSP file" : "invalid DIMENSION";
+		return false;
+	}
+	// a DIMENSION the rest of the file can not hold is rejected before anything is allocated for it,
+	// the last line may end without a newline
+	//
+	size_t left = file.size() - (size_t)(c._p - file.data());
+	if ((unsigned long long)spec._dimension * __TSPLIB_MIN_LINE__ > left + 1) {
+		*error = "DIMENSION exceeds the NODE_COORD_SECTION";
+		return false;
+	}
+	// read the "id x y" lines, ids are 1 based and may come in any order
+	//
+	int count = (int)spec._dimension;
+	vertices.resize(count);
+	vertices._metric = spec._metric;
+	char *seen = new char[count];
+	memset(seen, 0, count);
+	int read = 0;
+	while (read < count) {
+		long long id;
+		double x, y;
+		if (!c.integer(id) || !c.real(x) || !c.real(y) || id < 1 || id > count || seen[id - 1]) {
+			*error = "invalid NODE_COORD_SECTION";
+			break;
+		}
+		seen[id - 1] = 1;
+		vertices._x[id - 1] = (float)x;
+		vertices._y[id - 1] = (float)y;
+		read++;
+	}
+	delete[] seen;
+	if (read < count) {
+		vertices.clear();
+		return false;
+	}
+	return true;
+}
+
+
+
+// function to load the tour of a TSPLIB .opt.tour file into the given array of vtxCount 0 based city ids,
+// the file is memory mapped and parsed in place, return false and set error if the file is no tour of vtxCount cities
+//
+bool loadTSPLIBTour(const char *path, int vtxCount, unsigned *tour, const char **error) {
+	const char *dummy;
+	if (!error)
+		error = &dummy;
+	GMappedFile file;
+	if (!file.open(path)) {
+		*error = "can not open the file";
+		return false;
+	}
+	GTextCursor c(file.data(), file.data() + file.size());
+	TSPLIBSpec spec("TOUR");
+	if (!readSpecification(c, "TOUR_SECTION", spec)) {
+		*error = spec._error ? spec._error : "no TOUR_SECTION";
+		return false;
+	}
+	if (!spec._typeOk || (spec._dimension && spec._dimension != vtxCount)) {
+		*error = !spec._typeOk ? "not a TOUR file" : "DIMENSION does not match the cities";
+		return false;
+	}
+	// read the city ids up to -1, every city must be visited once
+	//
+	char *seen = new char[vtxCount];
+	memset(seen, 0, vtxCount);
+	int read = 0;
+	long long id;
+	bool ok = true;
+	while (c.integer(id) && id != -1) {
+		if (id < 1 || id > vtxCount || seen[id - 1] || read == vtxCount) {
+			ok = false;
+			break;
+		}
+		seen[id - 1] = 1;
+		tour[read++] = (unsigned)(id - 1);
+	}
+	delete[] seen;
+	if (!ok || read != vtxCount) {
+		*error = "invalid TOUR_SECTION";
+		return false;
+	}
+	return true;
+}
+
+
+
+#endif /*__TSPLIB_H__*/
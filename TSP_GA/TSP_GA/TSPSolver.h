@@ -0,0 +1,1511 @@
+#ifndef __TSPSOLVER_H__
+#define __TSPSOLVER_H__
+
+
+
+#include <ctime>
+#include <cstring>
+#include <cfloat>
+#include <chrono>
+#include <atomic>
+
+#include "DistanceOracle.h"
+#include "Random.h"
+#include "Crossover.h"
+#include "Population.h"
+#include "ThreadPool.h"
+#include "Islands.h"
+#include "LocalSearch.h"
+#include "SpatialIndex.h"
+#include "Checkpoint.h"
+#include "Telemetry.h"
+#include "TourExchange.h"
+#include "TourHash.h"
+
+#define __INF_LEN_TOUR__ FLT_MAX	// infinite tour length
+#define __DEADLINE_POLL__ 16		// child pairs made by a worker between two looks at the clock
+#define __UNIQUE_RETRIES__ 4		// mutations of a duplicate child looking for a new tour before it is dropped
+
+
+class TSPSolver;
+
+// progress call back, called by the solver after every generation,
+// improved is set to true if the generation found a better best tour
+//
+typedef void (*TSPProgressCallback)(const TSPSolver *solver, int generation, bool improved, void *data);
+
+
+// tours improved by the local search of the memetic mode
+//
+enum TSPLocalSearch {
+	TSP_LS_NONE,			// pure GA, no local search
+	TSP_LS_CHILDREN,		// every child, and every tour of the initial population, is improved before joining the population
+	TSP_LS_ELITE			// the best tours of every generation are improved after the selection
+};
+
+
+// scheme drawing the parents of the children among the survivors of the selection
+//
+enum TSPSelection {
+	TSP_SELECT_UNIFORM,		// every survivor alike
+	TSP_SELECT_TOURNAMENT,	// best of _tournamentSize survivors drawn alike
+	TSP_SELECT_RANK,		// weight falling linearly with the rank of the survivor, by an alias table
+	TSP_SELECT_FITNESS,		// weight proportional to the fitness of the survivor, 1 / length, by an alias table
+	TSP_SELECT_COUNT
+};
+
+// name of a selection scheme, as given on the command line
+//
+const char *selectionName(TSPSelection selection) {
+	static const char *names[TSP_SELECT_COUNT] = { "uniform", "tournament", "rank", "fitness" };
+	return names[selection];
+}
+
+// selection scheme of the given name, return false if no scheme has it
+//
+bool selectionByName(const char *name, TSPSelection &selection) {
+	for (int s = 0; s < TSP_SELECT_COUNT; s++)
+		if (!strcmp(name, selectionName((TSPSelection)s))) {
+			selection = (TSPSelection)s;
+			return true;
+		}
+	return false;
+}
+
+
+// GA parameters of a single solve
+//
+struct TSPConfig {
+	TSPConfig() : _generationIter(1), _populationCount(2), _mutationProb(0.0f), _seed(0), _threadCount(1),
+		_islandCount(1), _migrationInterval(50), _migrantCount(2), _migrationTopology(TSP_MIGRATE_RING),
+		_localSearch(TSP_LS_NONE), _eliteCount(1), _neighbourCount(8), _greedyCount(0), _checkpointPath(NULL), _checkpointInterval(0),
+		_timeLimit(0.0), _stallGenerations(0), _targetLength(0.0f), _crossover(G_CROSSOVER_CX), _smallSolver(true),
+		_selection(TSP_SELECT_UNIFORM), _tournamentSize(2), _uniqueTours(false), _packedTours(false), _neighbourMutation(false) {}
+	int _generationIter;		// generation itertion count, 0 runs until another termination or stop()
+	int _populationCount;		// population (chromosomes) count in each generation
+	float _mutationProb;		// mutation probability, between 0.0 and 1.0
+	unsigned _seed;				// random seed, 0 seeds from the clock
+	int _threadCount;			// worker threads making the offspring, 0 uses every hardware thread
+	int _islandCount;			// islands count, more than one runs the island model and splits the population and threads between the islands
+	int _migrationInterval;		// generations between two migrations of the island model, 0 never migrates
+	int _migrantCount;			// best tours sent by an island in every migration
+	TSPMigration _migrationTopology;	// island the migrants are sent to
+	TSPLocalSearch _localSearch;	// 2-opt and Or-opt local search of the memetic mode
+	int _eliteCount;			// best tours improved in every generation by the TSP_LS_ELITE local search
+	int _neighbourCount;		// nearest neighbours of every city, the candidates of local search, EAX, nearest neighbour tours and _neighbourMutation, the lists are only built for them, 0 builds none
+	int _greedyCount;			// tours of the initial population built by nearest neighbour from random cities, the others are random
+	const char *_checkpointPath;	// checkpoint file written while solving, NULL writes none, island i > 0 of the island model writes it with the suffix .i
+	int _checkpointInterval;	// generations between two checkpoints, 0 only writes one when the solve is stopped
+	double _timeLimit;			// seconds a solve may run, 0 has no limit, also checked within the generations
+	int _stallGenerations;		// generations without improvement of the best tour ending the solve, 0 never ends it
+	float _targetLength;		// best tour length ending the solve once reached, a known bound, 0 has no target
+	GCrossoverType _crossover;	// crossover operator making the children
+	bool _smallSolver;			// let create() pick the fixed size solver for the small instances it supports, see SmallSolver.h
+	TSPSelection _selection;	// scheme drawing the parents among the survivors
+	int _tournamentSize;		// survivors drawn by a tournament of TSP_SELECT_TOURNAMENT, at least 1
+	bool _uniqueTours;			// keep the tours of the population distinct by their hashes, and read the lengths of the tours seen before from a cache
+	bool _packedTours;			// keep the tours of the population bit packed, ceil(log2 cities) bits per city, for the instances whose population outgrows the memory
+	bool _neighbourMutation;	// mutation joins a random city to one of its nearest neighbours instead of swapping two random cities, needs _neighbourCount
+};
+
+
+// parent draws of the selection scheme of the config, among the survivors, which are on top of the population list
+// in rank order. a draw costs O(1), O(tournament size) for a tournament, on the random engine of the calling worker,
+// and the tournament needs no length comparison, its winner is the best ranked survivor drawn.
+// prepare() builds the alias table of the rank and fitness schemes on the solver thread once per generation, in O(survivors)
+//
+class TSPParentSelector {
+public:
+	TSPParentSelector() : _selection(TSP_SELECT_UNIFORM), _tournamentSize(2), _survivors(0), _rankSurvivors(0), _weights(NULL), _capacity(0) {}
+	~TSPParentSelector() { delete[] _weights; }
+
+	void configure(const TSPConfig &config) { _selection = config._selection; _tournamentSize = config._tournamentSize < 1 ? 1 : config._tournamentSize; _rankSurvivors = 0; }
+
+	// prepare the draws of the generation among the given count of survivors, in rank order
+	//
+	template <class TTour>
+	void prepare(TTour *const *survivors, int count);
+
+	// index of a parent among the survivors
+	//
+	int draw(GRandom &rng) const {
+		switch (_selection) {
+		case TSP_SELECT_TOURNAMENT: {
+			int best = rng.below(_survivors);
+			for (int t = 1; t < _tournamentSize; t++) {
+				int i = rng.below(_survivors);
+				if (i < best)
+					best = i;
+			}
+			return best;
+		}
+		case TSP_SELECT_RANK:
+		case TSP_SELECT_FITNESS:
+			return _table.draw(rng);
+		default:
+			return rng.below(_survivors);
+		}
+	}
+
+private:
+	TSPParentSelector(const TSPParentSelector &);
+	TSPParentSelector &operator=(const TSPParentSelector &);
+
+	TSPSelection _selection;	// scheme of the draws
+	int _tournamentSize;		// survivors drawn by a tournament
+	int _survivors;				// survivors count of the generation
+	int _rankSurvivors;			// survivors count of the rank table, which only changes with it
+	GAliasTable _table;			// alias table of the rank and fitness schemes
+	float *_weights;			// weights scratch of the table
+	int _capacity;				// weights count of the scratch
+};
+
+
+template <class TTour>
+void TSPParentSelector::prepare(TTour *const *survivors, int count) {
+	_survivors = count;
+	if (_selection != TSP_SELECT_RANK && _selection != TSP_SELECT_FITNESS)
+		return;
+	if (_selection == TSP_SELECT_RANK && count == _rankSurvivors)
+		return;
+	if (count > _capacity) {
+		delete[] _weights;
+		_capacity = count;
+		_weights = new float[_capacity];
+	}
+	// the rank weights count - i only depend on the survivors count
+	//
+	for (int i = 0; i < count; i++)
+		_weights[i] = _selection == TSP_SELECT_RANK ? (float)(count - i) : 1.0f / (survivors[i]->_length > 0.0f ? survivors[i]->_length : 1.0f);
+	_table.build(_weights, count);
+	_rankSurvivors = _selection == TSP_SELECT_RANK ? count : 0;
+}
+
+
+// reason a solve ended
+//
+enum TSPStopReason {
+	TSP_STOP_GENERATIONS,	// all generations of the config are done
+	TSP_STOP_USER,			// stop() was called
+	TSP_STOP_DEADLINE,		// the time limit was reached
+	TSP_STOP_STALL,			// the best tour was not improved for the stall generations
+	TSP_STOP_TARGET			// the best tour reached the target length
+};
+
+
+// outcome of a single solve
+//
+struct TSPResult {
+	TSPResult() : _bestTour(NULL), _generations(0), _stopped(false), _stopReason(TSP_STOP_GENERATIONS), _seconds(0.0), _checkpointError(NULL) {}
+	const GPath<unsigned> *_bestTour;		// best tour found, owned by the solver
+	int _generations;			// completed generations, those done before the checkpoint of a resumed solve included
+	bool _stopped;				// true if the solve was interrupted within a generation, by stop() or the time limit
+	TSPStopReason _stopReason;	// reason the solve ended
+	double _seconds;			// wall time spent in solve(), and in the solves before the checkpoint of a resumed solve
+	const char *_checkpointError;	// reason the last checkpoint was not written, NULL if all were
+};
+
+
+// sections of a solver checkpoint file
+//
+enum TSPCheckpointSection {
+	TSP_CK_STATE,			// TSPCheckpointState
+	TSP_CK_CITIES_X,		// x positions of the cities
+	TSP_CK_CITIES_Y,		// y positions of the cities
+	TSP_CK_BEST,			// best tour, unsigned city ids
+	TSP_CK_RANDOM,			// states of the random engines, the solver one then one per worker
+	TSP_CK_LENGTHS,			// tour lengths of the population, in population list order
+	TSP_CK_GENES,			// tours of the population, in the tour index type of the solver
+	TSP_CK_FITNESS			// entries of the fitness cache, only with _uniqueTours
+};
+
+// state of a solver at a checkpoint, the first section of the file
+//
+struct TSPCheckpointState {
+	TSPConfig _runConfig;		// parameters given to create(), for an island those of the whole island model
+	TSPConfig _config;			// parameters of this solver
+	int _vtxCount;				// cities count
+	int _metric;				// GMetric of the cities
+	int _idxBytes;				// bytes of a tour index in the genes section
+	int _island;				// index of the island, 0 without the island model
+	int _survivors;				// survivors count on top of the population list
+	int _generation;			// generations done, the resumed solve starts with this one
+	int _workerCount;			// worker random engines in the random section
+	float _bestLength;			// length of the best tour
+	double _seconds;			// solve time spent up to the checkpoint
+};
+
+
+// TSP solver using GA based on the crossover of the config, CX by default, and rank-based selection of the survivors,
+// the parents of the children are drawn among the survivors by the selection scheme of the config,
+// owns its population and a copy of the best tour, so it is usable without any UI,
+// the vertex store must outlive the solver, its distance oracle may be shared by the caller, otherwise the solver builds its own.
+// create() picks the solver instance with the narrowest tour index type for the cities count
+//
+class TSPSolver {
+public:
+	static TSPSolver *create(const GVertexStore &vertices, const TSPConfig &config, const GDistanceOracle *dist = NULL, const GNeighbours *neighbours = NULL);
+	virtual ~TSPSolver();
+
+	void callback(TSPProgressCallback cb, void *data) { _callback = cb; _callbackData = data; }
+	virtual void telemetry(TSPTelemetry *sink) { _telemetry = sink; }		// write a record of every generation to the sink, NULL records nothing
+
+	// publish a copy of every new best tour to the given exchange, allocated for the cities count of the solver,
+	// so another thread reads the best tour while the solver runs without ever blocking it, NULL publishes nothing
+	//
+	void publisher(GTourExchange *exchange) { _publisher = exchange && exchange->vtxCount() == _vtxCount ? exchange : NULL; }
+	virtual const TSPResult &solve() = 0;		// run the GA, blocking until it completes or stop() is called
+	virtual void stop() { _stopComputing.store(true, std::memory_order_relaxed); }
+
+	// continue the next solve() from the given checkpoint instead of a new population, the cities and the population count
+	// must be those of the checkpoint, return false and set error if the checkpoint can not be used
+	//
+	virtual bool resume(const char *path, const char **error) = 0;
+
+	// read the cities and the parameters given to create() of the run which wrote the given checkpoint,
+	// return false and set error if the file is no checkpoint
+	//
+	static bool readCheckpoint(const char *path, GVertexStore &vertices, TSPConfig &config, const char **error);
+
+	const TSPConfig &config() const { return _config; }
+	const TSPResult &result() const { return _result; }
+	const GPath<unsigned> *bestTour() const { return _bestTour; }
+	int vtxCount() const { return _vtxCount; }
+
+protected:
+	TSPSolver(const GVertexStore &vertices, const TSPConfig &config, const GDistanceOracle *dist, const GNeighbours *neighbours);
+
+	template <typename TIdx>
+	void updateBestTour(const GPath<TIdx> *tour);
+	void publishBestTour();
+	double elapsed() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count(); }
+
+	// start the time limit of the config from now, before anything of the solve is done
+	//
+	void startDeadline() {
+		_deadlineReached.store(false, std::memory_order_relaxed);
+		_deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(_config._timeLimit));
+	}
+
+	// true if the solve has a time limit and it is reached, then the solve is stopped as by stop()
+	//
+	bool deadlineReached() {
+		if (_config._timeLimit <= 0.0 || std::chrono::steady_clock::now() < _deadline)
+			return false;
+		_deadlineReached.store(true, std::memory_order_relaxed);
+		_stopComputing.store(true, std::memory_order_relaxed);
+		return true;
+	}
+
+	// make the tour hash, set and fitness cache of the _uniqueTours config
+	//
+	void allocateUnique() {
+		_tourHash.build(_vtxCount);
+		_tourSet.allocate(_config._populationCount);
+		_fitnessCache.allocate(_config._populationCount);
+	}
+
+	// fill the tour set with the survivors before the children of a generation are made, the workers only read it
+	// while they make the children, which join it once they are all made. TTour is any tour type with a _hash
+	//
+	template <class TTour>
+	void resetTourSet(TTour *const *survivors, int count) {
+		_tourSet.reset();
+		for (int i = 0; i < count; i++)
+			_tourSet.insert(survivors[i]->_hash);
+	}
+
+	// seconds since the given time, which is moved to now
+	//
+	static double lap(std::chrono::steady_clock::time_point &tick) {
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(now - tick).count();
+		tick = now;
+		return seconds;
+	}
+
+	const GVertexStore *_vertices;		// cities
+	int _vtxCount;						// cities count
+	GDistanceOracle *_ownDist;			// distance oracle built by the solver, NULL if shared
+	const GDistanceOracle *_dist;		// distance oracle used for all length evaluations
+	GNeighbours *_ownNeighbours;		// neighbour lists built by the solver, NULL if shared or not used
+	const GNeighbours *_neighbours;		// neighbour lists of the cities, NULL if the config builds none or has no consumer for them
+	TSPConfig _config;					// GA parameters
+	TSPConfig _runConfig;				// parameters given to create(), those of the whole island model for an island, kept in the checkpoints
+	GPath<unsigned> *_bestTour;			// copy of the best tour found so far
+	std::atomic<bool> _stopComputing;	// stop condition flag, set by stop() or by the worker reaching the time limit, read by all workers
+	std::atomic<bool> _deadlineReached;	// the time limit set the stop flag, rather than stop()
+	std::chrono::steady_clock::time_point _deadline;	// end of the time limit of the current solve, if it has one
+	TSPProgressCallback _callback;
+	void *_callbackData;
+	TSPTelemetry *_telemetry;			// sink of the generation records, NULL if there is none
+	GTourExchange *_publisher;			// exchange the best tours are published to, NULL if they are not
+	TSPResult _result;
+	GRandom _rng;						// random engine of the solver thread, drives the selection
+	TSPParentSelector _parents;			// parent draws of the workers among the survivors
+	GTourHash _tourHash;				// tour hash of the _uniqueTours config
+	GTourSet _tourSet;					// hashes of the survivors, then of the whole population, with _uniqueTours
+	GFitnessCache _fitnessCache;		// lengths of the tours seen before, with _uniqueTours
+	std::chrono::steady_clock::time_point _start;		// start time of the current solve
+
+private:
+	TSPSolver(const TSPSolver &);
+	TSPSolver &operator=(const TSPSolver &);
+};
+
+
+// state owned by one worker thread of the solver, its random engine and scratch buffers,
+// so the offspring loop shares nothing but the read only survivors
+//
+template <typename TIdx>
+struct TSPWorker {
+	TSPWorker() : _visited(NULL), _cellLeft(NULL), _position(NULL), _positionOf(NULL), _spare(0), _crossovers(0), _mutations(0), _evaluations(0), _duplicates(0), _cacheHits(0) {}
+	~TSPWorker() { delete[] _visited; delete[] _cellLeft; delete[] _position; delete[] _unpacked[0]._path; delete[] _unpacked[1]._path; }
+	GRandom _rng;					// random engine of the worker
+	GCrossoverScratch<TIdx> _crossover;	// scratch buffers of the crossover operator
+	GLocalSearch<TIdx> _localSearch;	// local search of the memetic mode, with its scratch buffers
+	char *_visited;					// visited flags scratch of the nearest neighbour tours
+	int *_cellLeft;					// grid cell counts scratch of the nearest neighbour tours
+	TIdx *_position;				// inverse "city -> position" index of the tour mutated last, with _neighbourMutation
+	const TIdx *_positionOf;		// path of that tour, NULL once it is changed by anything but mutate()
+	int _spare;						// first of the two child slots of the worker in the arena
+	GPath<TIdx> _unpacked[2];		// parents unpacked from the packed population, with _packedTours
+	GTourSet _children;				// hashes of the children of the worker in the current generation, with _uniqueTours
+	long long _crossovers;			// crossovers since the last generation record
+	long long _mutations;			// mutations since the last generation record
+	long long _evaluations;			// full tour length evaluations since the last generation record
+	long long _duplicates;			// duplicate children since the last generation record
+	long long _cacheHits;			// children lengths read from the fitness cache since the last generation record
+};
+
+
+// solver instance storing its tours as TIdx city indices
+//
+template <typename TIdx>
+class TSPSolverT : public TSPSolver {
+public:
+	TSPSolverT(const GVertexStore &vertices, const TSPConfig &config, const GDistanceOracle *dist, const GNeighbours *neighbours = NULL)
+		: TSPSolver(vertices, config, dist, neighbours), _toursPopulationList(NULL), _workers(NULL), _threadCount(0), _survivors(0), _island(NULL) {}
+	~TSPSolverT() { delete[] _workers; }
+
+	const TSPResult &solve();
+	bool resume(const char *path, const char **error);
+
+	// make the solver an island of the island model run with the given parameters
+	//
+	void island(TSPIslandLink<TIdx> *link, const TSPConfig &runConfig) { _island = link; _runConfig = runConfig; }
+
+	template <typename> friend class TSPIslandSolver;		// clears the stop flags of its islands before they start
+
+protected:
+	void makeWorkers(int threadCount);
+	void generateRandPath(TSPWorker<TIdx> &w, GPath<TIdx> *gPath);
+	void initiatePopulation(GThreadPool &pool);
+	void sortTours(int from);
+	bool selectByProbability(GRandom &rng, float p);
+	void mutate(TSPWorker<TIdx> &w, GPath<TIdx> *tour);
+	int selectSurvivors(int sorted);
+	template <class TCross> void crossover(TSPWorker<TIdx> &w, const GPath<TIdx> *parent1, const GPath<TIdx> *parent2, GPath<TIdx> *child1, GPath<TIdx> *child2);
+	void evaluate(TSPWorker<TIdx> &w, GPath<TIdx> *child);
+	bool admit(TSPWorker<TIdx> &w, GPath<TIdx> *child, const GPath<TIdx> *looser);
+	void reconcile();
+	const GPath<TIdx> *parent(TSPWorker<TIdx> &w, int k, int p);
+	GPath<TIdx> *unpackTour(int i);
+	void makeInitialTours(int thread);
+	void makeOffspring(int thread);
+	template <class TCross> void makeOffspringT(int thread);
+	void migrate();
+	void improveElite();
+	void recordGeneration(int generation, double offspringSeconds, double selectionSeconds, double generationSeconds);
+	void writeCheckpoint(int generation);
+	int restoreCheckpoint();
+
+	static void initialToursTask(void *data, int thread) { ((TSPSolverT *)data)->makeInitialTours(thread); }
+	static void offspringTask(void *data, int thread) { ((TSPSolverT *)data)->makeOffspring(thread); }
+
+	GPopulation<TIdx> _population;			// population arena
+	GPath<TIdx> **_toursPopulationList;		// population list array of the arena
+	TSPWorker<TIdx> *_workers;				// per thread state, one per pool thread
+	int _threadCount;						// threads count of the current solve
+	int _survivors;							// survivors count of the current generation, the parents
+	TSPIslandLink<TIdx> *_island;			// link to the other islands, NULL if the solver runs alone
+	GCheckpoint _checkpoint;				// checkpoint given to resume(), mapped until the next solve() restores it
+};
+
+
+TSPSolver::TSPSolver(const GVertexStore &vertices, const TSPConfig &config, const GDistanceOracle *dist, const GNeighbours *neighbours)
+	: _vertices(&vertices), _vtxCount(vertices._count), _ownDist(NULL), _dist(dist), _ownNeighbours(NULL), _neighbours(NULL),
+	_config(config), _runConfig(config), _stopComputing(false), _deadlineReached(false), _callback(NULL), _callbackData(NULL), _telemetry(NULL), _publisher(NULL) {
+	if (!_dist)
+		_dist = _ownDist = new GDistanceOracle(vertices);
+#ifdef __TSP_CROSSOVER__
+	_config._crossover = _runConfig._crossover = __TSP_CROSSOVER__::_type;
+#endif
+	// the neighbour lists are only built or used when the config has a consumer for them, the local search, EAX,
+	// the neighbour mutation or the nearest neighbour tours, shared lists are used with their own count
+	//
+	bool consumer = _config._localSearch != TSP_LS_NONE || _config._crossover == G_CROSSOVER_EAX || _config._neighbourMutation || _config._greedyCount > 0;
+	if (consumer && _config._neighbourCount > 0 && _vtxCount > 1) {
+		_neighbours = neighbours;
+		if (!_neighbours)
+			_neighbours = _ownNeighbours = new GNeighbours(vertices, _config._neighbourCount);
+		if (!_neighbours->count())
+			_neighbours = NULL;
+	}
+	_bestTour = new GPath<unsigned>;
+	_bestTour->_path = new unsigned[_vtxCount];
+	_bestTour->_length = __INF_LEN_TOUR__;
+}
+
+TSPSolver::~TSPSolver() {
+	delete[] _bestTour->_path;
+	delete _bestTour;
+	delete _ownDist;
+	delete _ownNeighbours;
+}
+
+// function to generate a random path, tour indeed, by shuffling the identity permutation in O(n),
+// written into the given tour
+//
+template <typename TIdx>
+void TSPSolverT<TIdx>::generateRandPath(TSPWorker<TIdx> &w, GPath<TIdx> *gPath) {
+	for (int i = 0; i < _vtxCount; i++)
+		gPath->_path[i] = (TIdx)i;
+	w._rng.shuffle(gPath->_path, _vtxCount);
+	gPath->updateLength(*_dist);
+}
+
+
+
+// make the state of the given count of worker threads, every worker has its own random engine and scratch buffers
+//
+template <typename TIdx>
+void TSPSolverT<TIdx>::makeWorkers(int threadCount) {
+	_threadCount = threadCount;
+	delete[] _workers;
+	_workers = new TSPWorker<TIdx>[_threadCount];
+	for (int t = 0; t < _threadCount; t++) {
+		_workers[t]._rng.seed(_config._seed ? _config._seed + ((unsigned long long)(t + 1) << 32) : 0);
+		_workers[t]._crossover.allocate(_vtxCount, _config._crossover);
+		if (_neighbours)
+			_workers[t]._crossover.candidates(_neighbours->lists(), _neighbours->count());
+		_workers[t]._spare = 2 * t;
+		if (_config._uniqueTours)
+			_workers[t]._children.allocate(_config._populationCount / _threadCount + 2);
+		if (_config._packedTours)
+			for (int k = 0; k < 2; k++)
+				_workers[t]._unpacked[k]._path = new TIdx[_vtxCount];
+		if (_config._localSearch != TSP_LS_NONE) {
+			_workers[t]._localSearch.allocate(_vtxCount);
+			if (_neighbours)
+				_workers[t]._localSearch.candidates(_neighbours->lists(), _neighbours->count());
+		}
+		if (_config._neighbourMutation && _neighbours)
+			_workers[t]._position = new TIdx[_vtxCount];
+		if (_config._greedyCount > 0 && _neighbours) {
+			_workers[t]._visited = new char[_vtxCount];
+			_workers[t]._cellLeft = new int[_neighbours->index().cellCount()];
+		}
+	}
+}
+
+
+
+// worker part of the initial population, the thread fills its own share of the population
+//
+template <typename TIdx>
+void TSPSolverT<TIdx>::makeInitialTours(int thread) {
+	int count = _config._populationCount;
+	TSPWorker<TIdx> &w = _workers[thread];
+	for (int i = count * thread / _threadCount; i < count * (thread + 1) / _threadCount; i++) {
+		// a packed tour is built in the child slot of the worker, then packed into the population
+		//
+		GPath<TIdx> *tour = _population.packed() ? _population.spare(w._spare) : _toursPopulationList[i];
+		if (i < _config._greedyCount && _neighbours) {
+			nearestNeighbourTour(*_neighbours, _vtxCount, w._rng.below(_vtxCount), tour->_path, w._visited, w._cellLeft);
+			tour->updateLength(*_dist);
+		}
+		else
+			generateRandPath(w, tour);
+		// the local search of the initial tours may outlast the time limit, the tours left once it is reached stay as they are,
+		// so the population is complete and the solve ends with the best tour so far
+		//
+		if (_config._localSearch == TSP_LS_CHILDREN && !_deadlineReached.load(std::memory_order_relaxed) && ((i + 1) % __DEADLINE_POLL__ || !deadlineReached()))
+			w._localSearch.optimize(tour, *_dist);
+		if (_config._uniqueTours)
+			tour->_hash = _tourHash.tour(tour->_path);
+		if (_population.packed())
+			_population.replace(i, w._spare);
+	}
+}
+
+
+
+// function to generate the initial population, random chromosomes,
+// set _toursPopulationList variable, every worker gets its own two child slots in the arena
+//
+template <typename TIdx>
+void TSPSolverT<TIdx>::initiatePopulation(GThreadPool &pool) {
+	_population.allocate(_config._populationCount, 2 * _threadCount, _vtxCount, _config._packedTours);
+	_toursPopulationList = _population.tours();
+	pool.run(initialToursTask, this);
+}
+
+
+
+// function to merge the sorted runs A[l..m] and A[m+1..u] by tour length, using B as scratch of at least u-l+1 entries,
+// equal tours keep their order, so the merge is stable. TTour is any tour type with a _length
+//
+template <typename TTour>
+void merge(TTour **A, TTour **B, unsigned l, unsigned m, unsigned u) {
+	unsigned h = l;
+	unsigned k = m + 1;
+	unsigned j = 0;
+	while (h <= m  &&  k <= u) {
+		if (A[k]->_length < A[h]->_length)
+			B[j++] = A[k++];
+		else
+			B[j++] = A[h++];
+	}
+	if (h > m)	for (unsigned r = k; r <= u; B[j++] = A[r++]);
+	else		for (unsigned r = h; r <= m; B[j++] = A[r++]);
+	for (unsigned r = l; r <= u; r++) A[r] = B[r - l];
+}
+template <typename TTour>
+void mergeSort(TTour **A, TTour **B, unsigned l, unsigned u) {
+	if (l < u){
+		unsigned m = (l + u) / 2;
+		mergeSort(A, B, l, m);
+		mergeSort(A, B, m + 1, u);
+		if (A[m + 1]->_length < A[m]->_length)
+			merge(A, B, l, m, u);
+	}
+}
+
+
+
+// function to sort the tours in the current population based on fitnesses, i.e. the length of the tour,
+// the tours before from are already sorted, so only the new tours are merge sorted and then merged into them,
+// O(P log P) at worst, the scratch list of the arena is used as merge buffer so nothing is allocated
+//
+template <typename TIdx>
+void TSPSolverT<TIdx>::sortTours(int from) {
+	int count = _config._populationCount;
+	GPath<TIdx> **scratch = _population.scratch();
+	if (from < count - 1)
+		mergeSort(_toursPopulationList, scratch, from, count - 1);
+	if (from > 0 && from < count && _toursPopulationList[from]->_length < _toursPopulationList[from - 1]->_length)
+		merge(_toursPopulationList, scratch, 0, from - 1, count - 1);
+}
+
+
+
+// function to select, return true, based on the given probability value, between 0.0 and 1.0,
+// return false otherswise
+//
+template <typename TIdx>
+bool TSPSolverT<TIdx>::selectByProbability(GRandom &rng, float p) {
+	if (rng.uniform() < p)
+		return true;
+	else
+		return false;
+}
+
+
+
+// function to operation mutation on the given chromosome,
+// with _neighbourMutation a random city is joined to one of its nearest neighbours, otherwise two random cities are swapped
+//
+template <typename TIdx>
+void TSPSolverT<TIdx>::mutate(TSPWorker<TIdx> &w, GPath<TIdx> *tour) {
+	// select to random indicex, r1 and r2
+	//
+	int r1 = w._rng.below(_vtxCount);
+	int r2;
+	if (_config._neighbourMutation && _neighbours) {
+		// r2 is the position of a near city, which is swapped with the successor of r1 so the two cities become adjacent,
+		// if it is already the successor it is swapped with r1 instead. the position is read from the inverse index,
+		// built once per tour, at its first mutation, and kept up to date by the swaps of the next ones
+		//
+		if (w._positionOf != tour->_path) {
+			for (int i = 0; i < _vtxCount; i++)
+				w._position[tour->_path[i]] = (TIdx)i;
+			w._positionOf = tour->_path;
+		}
+		TIdx near = (TIdx)(*_neighbours)[tour->_path[r1]][w._rng.below(_neighbours->count())];
+		r2 = w._position[near];
+		int next = r1 + 1 == _vtxCount ? 0 : r1 + 1;
+		if (r2 != next)
+			r1 = next;
+	}
+	else {
+		r2 = w._rng.below(_vtxCount);
+		// guarantee the r1 and r2 are not equal
+		//
+		while (r1 == r2)
+			r2 = w._rng.below(_vtxCount);
+	}
+	// swap the two randomly selected genes, the mutated chromosome length is updated by the change of the four edges around them,
+	// and so is its hash
+	//
+	if (_config._uniqueTours)
+		tour->_hash ^= _tourHash.swapDelta(tour->_path, r1, r2);
+	tour->swapCities(*_dist, r1, r2);
+	if (w._positionOf == tour->_path) {
+		w._position[tour->_path[r1]] = (TIdx)r1;
+		w._position[tour->_path[r2]] = (TIdx)r2;
+	}
+	w._mutations++;
+}
+
+
+
+// function to select survivors based on the rank-based selection ,method by the probability of (i/n),
+// the first sorted tours are the survivors of the last selection and are still in rank order,
+// return the index of the last survivor + 1, i.e. the index of the first looser
+//
+template <typename TIdx>
+int TSPSolverT<TIdx>::selectSurvivors(int sorted) {
+	// first sort the population, so the best fitted choromosomes are on the top
+	//
+	sortTours(sorted);
+	int k = 0, l = 0;
+	GPath<TIdx> **loosers = _population.scratch();
+	// iterate through all the chromosomes to select the survivors based on the rank-based probability, i.e. (i/n),
+	// the survivors are compacted to the top in rank order and the loosers are moved below them, a linear stable partition
+	//
+	for (int i = 0; i < _config._populationCount; i++) {
+		if (selectByProbability(_rng, 1.0f - (float)i / _config._populationCount))
+			_toursPopulationList[k++] = _toursPopulationList[i];
+		else
+			loosers[l++] = _toursPopulationList[i];
+	}
+	memcpy(_toursPopulationList + k, loosers, l * sizeof(GPath<TIdx> *));
+	// now k is the index of the last survivor + 1, i.e. the index of the first looser
+	//
+	return k;
+}
+
+
+
+// function to cross over two parents with the TCross policy into the given children, child2 may be NULL,
+// and update the children tour lengths
+//
+template <typename TIdx>
+template <class TCross>
+void TSPSolverT<TIdx>::crossover(TSPWorker<TIdx> &w, const GPath<TIdx> *parent1, const GPath<TIdx> *parent2, GPath<TIdx> *child1, GPath<TIdx> *child2) {
+	TCross::cross(parent1->_path, parent2->_path, child1->_path, child2 ? child2->_path : (TIdx *)NULL, w._crossover, _vtxCount, w._rng, *_dist);
+	w._positionOf = NULL;
+	evaluate(w, child1);
+	if (child2)
+		evaluate(w, child2);
+	w._crossovers++;
+}
+
+// function to update the length of a new child, with _uniqueTours its hash too, and its length is read
+// from the fitness cache when the tour was seen in a former generation
+//
+template <typename TIdx>
+void TSPSolverT<TIdx>::evaluate(TSPWorker<TIdx> &w, GPath<TIdx> *child) {
+	if (_config._uniqueTours) {
+		child->_hash = _tourHash.tour(child->_path);
+		if (_fitnessCache.find(child->_hash, child->_length)) {
+			child->checkLength(*_dist, "fitness cache");
+			w._cacheHits++;
+			return;
+		}
+	}
+	child->updateLength(*_dist);
+	w._evaluations++;
+}
+
+// function to admit a child into the population in place of the given looser, return false if it is rejected,
+// a child which is a survivor or a child the worker made before is mutated until it is new, and rejected if it is still
+// a duplicate after a few mutations, the looser then stays. the children of the other workers are only compared
+// by reconcile(), so which child is a duplicate does not depend on the timing of the threads
+//
+template <typename TIdx>
+bool TSPSolverT<TIdx>::admit(TSPWorker<TIdx> &w, GPath<TIdx> *child, const GPath<TIdx> *looser) {
+	for (int r = 0; r <= __UNIQUE_RETRIES__; r++) {
+		if (!_tourSet.contains(child->_hash) && w._children.insert(child->_hash))
+			return true;
+		w._duplicates++;
+		if (r < __UNIQUE_RETRIES__)
+			mutate(w, child);
+	}
+	w._children.insert(looser->_hash);
+	return false;
+}
+
+// function to add the children of the generation to the tour set once they are all made, on the solver thread in index order,
+// a child found again, made by another worker, is mutated by the first worker until it is new, and stays if it is still
+// a duplicate after a few mutations. the lengths of the children then join the fitness cache, which the workers only read
+//
+template <typename TIdx>
+void TSPSolverT<TIdx>::reconcile() {
+	TSPWorker<TIdx> &w = _workers[0];
+	for (int k = _survivors; k < _config._populationCount; k++) {
+		if (!_tourSet.insert(_toursPopulationList[k]->_hash)) {
+			GPath<TIdx> *tour = unpackTour(k);
+			w._positionOf = NULL;
+			for (int r = 0; r < __UNIQUE_RETRIES__; r++) {
+				w._duplicates++;
+				mutate(w, tour);
+				if (_tourSet.insert(tour->_hash))
+					break;
+			}
+			if (_population.packed())
+				_population.replace(k, 0);
+		}
+		_fitnessCache.store(_toursPopulationList[k]->_hash, _toursPopulationList[k]->_length);
+	}
+}
+
+
+
+// copy the given tour into the best tour buffer owned by the solver,
+// so the best tour stays valid while the population is recycled
+//
+template <typename TIdx>
+void TSPSolver::updateBestTour(const GPath<TIdx> *tour) {
+	for (int i = 0; i < _vtxCount; i++)
+		_bestTour->_path[i] = tour->_path[i];
+	_bestTour->_length = tour->_length;
+	if (_publisher)
+		publishBestTour();
+}
+
+// copy the best tour into the back buffer of the exchange and publish it
+//
+void TSPSolver::publishBestTour() {
+	GTourSnapshot *snapshot = _publisher->back();
+	memcpy(snapshot->_path, _bestTour->_path, _vtxCount * sizeof(unsigned));
+	snapshot->_length = _bestTour->_length;
+	snapshot->_generation = _result._generations;
+	_publisher->publish();
+}
+
+
+
+// worker part of a generation, the loosers below the survivors are replaced by children in pairs,
+// the pairs are split evenly between the threads, so every thread writes its own population positions and child slots,
+// and the parents are only drawn from the survivors, which are not written during the generation.
+// a build may fix the crossover at compile time, e.g. -D__TSP_CROSSOVER__=GCrossoverOX, then the offspring loop
+// is only instantiated for that policy, and the solvers replace the _crossover of their config by its _type
+//
+template <typename TIdx>
+void TSPSolverT<TIdx>::makeOffspring(int thread) {
+#ifdef __TSP_CROSSOVER__
+	makeOffspringT<__TSP_CROSSOVER__>(thread);
+#else
+	switch (_config._crossover) {
+	case G_CROSSOVER_OX: makeOffspringT<GCrossoverOX>(thread); break;
+	case G_CROSSOVER_PMX: makeOffspringT<GCrossoverPMX>(thread); break;
+	case G_CROSSOVER_ERX: makeOffspringT<GCrossoverERX>(thread); break;
+	case G_CROSSOVER_EAX: makeOffspringT<GCrossoverEAX>(thread); break;
+	default: makeOffspringT<GCrossoverCX>(thread); break;
+	}
+#endif
+}
+
+// parent p of the population list with its path, unpacked into the buffer k of the worker with _packedTours
+//
+template <typename TIdx>
+const GPath<TIdx> *TSPSolverT<TIdx>::parent(TSPWorker<TIdx> &w, int k, int p) {
+	if (!_population.packed())
+		return _toursPopulationList[p];
+	_population.read(_toursPopulationList[p], w._unpacked[k]._path);
+	w._unpacked[k]._length = _toursPopulationList[p]->_length;
+	return &w._unpacked[k];
+}
+
+// tour i of the population list with its path, unpacked into the first child slot with _packedTours,
+// only on the solver thread between two generations, replace(i, 0) packs it back once it is changed
+//
+template <typename TIdx>
+GPath<TIdx> *TSPSolverT<TIdx>::unpackTour(int i) {
+	if (!_population.packed())
+		return _toursPopulationList[i];
+	GPath<TIdx> *tour = _population.spare(0);
+	_population.read(_toursPopulationList[i], tour->_path);
+	tour->_length = _toursPopulationList[i]->_length;
+	tour->_hash = _toursPopulationList[i]->_hash;
+	return tour;
+}
+
+
+
+// the offspring loop of the TCross crossover
+//
+template <typename TIdx>
+template <class TCross>
+void TSPSolverT<TIdx>::makeOffspringT(int thread) {
+	TSPWorker<TIdx> &w = _workers[thread];
+	int count = _config._populationCount;
+	int pairs = (count - _survivors + 1) / 2;
+	if (_config._uniqueTours)
+		w._children.reset();
+	for (int j = pairs * thread / _threadCount; j < pairs * (thread + 1) / _threadCount; j++) {
+		// k is the index of the looser replaced by the child1, the next looser is replaced by the child2 if there is one
+		//
+		int k = _survivors + 2 * j;
+		// draw p1 and p2 by the selection scheme
+		//
+		int p1 = _parents.draw(w._rng);
+		int p2 = _parents.draw(w._rng);
+		// guarantee p1 and p2 are not equal
+		//
+		while (_survivors > 1 && p1 == p2)
+			p2 = _parents.draw(w._rng);
+		// the children are made in the child slots of the worker
+		//
+		GPath<TIdx> *child1 = _population.spare(w._spare);
+		GPath<TIdx> *child2 = k + 1 < count ? _population.spare(w._spare + 1) : NULL;
+		// operate the cross over on p1 and p2 chromosomes to generate child1 and child2
+		//
+		crossover<TCross>(w, parent(w, 0, p1), parent(w, 1, p2), child1, child2);
+		// mutate the child1 based on the given probability and swap it with the old one
+		//
+		if (_config._mutationProb != 0.0f  &&  selectByProbability(w._rng, _config._mutationProb))
+			mutate(w, child1);
+		if (_config._localSearch == TSP_LS_CHILDREN && w._localSearch.optimize(child1, *_dist)) {
+			w._positionOf = NULL;
+			if (_config._uniqueTours)
+				child1->_hash = _tourHash.tour(child1->_path);
+		}
+		if (!_config._uniqueTours || admit(w, child1, _toursPopulationList[k]))
+			_population.replace(k, w._spare);
+		// mutate the child2 based on the given probability and swap it with the old one
+		//
+		if (child2) {
+			if (_config._mutationProb != 0.0f  &&  selectByProbability(w._rng, _config._mutationProb))
+				mutate(w, child2);
+			if (_config._localSearch == TSP_LS_CHILDREN && w._localSearch.optimize(child2, *_dist)) {
+				w._positionOf = NULL;
+				if (_config._uniqueTours)
+					child2->_hash = _tourHash.tour(child2->_path);
+			}
+			if (!_config._uniqueTours || admit(w, child2, _toursPopulationList[k + 1]))
+				_population.replace(k + 1, w._spare + 1);
+		}
+		// check if the stop was requested or the time limit is reached, the clock is only read every few pairs
+		// if so, terminate the computation
+		//
+		if (_stopComputing.load(std::memory_order_relaxed) || ((j + 1) % __DEADLINE_POLL__ == 0 && deadlineReached()))
+			return;
+	}
+}
+
+
+
+// function to exchange migrants with the other islands,
+// the incoming migrants overwrite the last children, so they compete with them in the next selection,
+// then the best survivors are sent out, none of both ever waits for the other islands
+//
+template <typename TIdx>
+void TSPSolverT<TIdx>::migrate() {
+	int count = _config._populationCount;
+	GMigrants<TIdx> *in = _island->receive();
+	if (in) {
+		for (int m = 0; m < in->_count && m < count - _survivors; m++) {
+			GPath<TIdx> *tour = _toursPopulationList[count - 1 - m];
+			_population.write(tour, in->_genes + m * _vtxCount);
+			tour->_length = in->_lengths[m];
+			if (_config._uniqueTours)
+				tour->_hash = _tourHash.tour(in->_genes + m * _vtxCount);
+		}
+		_island->release(in);
+	}
+	GMigrants<TIdx> *out = _island->outgoing();
+	if (out) {
+		out->_count = _island->migrantCount() < _survivors ? _island->migrantCount() : _survivors;
+		for (int m = 0; m < out->_count; m++) {
+			_population.read(_toursPopulationList[m], out->_genes + m * _vtxCount);
+			out->_lengths[m] = _toursPopulationList[m]->_length;
+		}
+		_island->send(out, _rng);
+	}
+}
+
+
+
+// function to improve the best survivors by the local search, on the solver thread between two generations,
+// the improved tours only get shorter, so they stay ahead of the other survivors and only need sorting among themselves
+//
+template <typename TIdx>
+void TSPSolverT<TIdx>::improveElite() {
+	int elite = _config._eliteCount < _survivors ? _config._eliteCount : _survivors;
+	for (int e = 0; e < elite; e++) {
+		GPath<TIdx> *tour = unpackTour(e);
+		if (!_workers[0]._localSearch.optimize(tour, *_dist))
+			continue;
+		if (_config._uniqueTours)
+			tour->_hash = _tourHash.tour(tour->_path);
+		if (_population.packed())
+			_population.replace(e, 0);
+	}
+	if (elite > 1)
+		mergeSort(_toursPopulationList, _population.scratch(), 0, elite - 1);
+}
+
+
+
+// function to write the record of the given generation to the telemetry sink, the population is sorted by the selection,
+// the worker counters are summed and cleared for the next generation
+//
+template <typename TIdx>
+void TSPSolverT<TIdx>::recordGeneration(int generation, double offspringSeconds, double selectionSeconds, double generationSeconds) {
+	int count = _config._populationCount;
+	TSPGenerationStats stats;
+	stats._generation = generation;
+	stats._island = _island ? _island->index() : 0;
+	double sum = 0.0;
+	float worst = 0.0f;
+	for (int i = 0; i < count; i++) {
+		float length = _toursPopulationList[i]->_length;
+		sum += length;
+		if (length > worst)
+			worst = length;
+	}
+	stats._best = _toursPopulationList[0]->_length;
+	stats._mean = (float)(sum / count);
+	stats._worst = worst;
+	long long crossovers = 0, mutations = 0, evaluations = 0, duplicates = 0, cacheHits = 0;
+	for (int t = 0; t < _threadCount; t++) {
+		crossovers += _workers[t]._crossovers;
+		mutations += _workers[t]._mutations;
+		evaluations += _workers[t]._evaluations;
+		duplicates += _workers[t]._duplicates;
+		cacheHits += _workers[t]._cacheHits;
+		_workers[t]._crossovers = _workers[t]._mutations = _workers[t]._evaluations = _workers[t]._duplicates = _workers[t]._cacheHits = 0;
+	}
+	stats._crossovers = (int)crossovers;
+	stats._mutations = (int)mutations;
+	stats._evaluations = (int)evaluations;
+	stats._duplicates = (int)duplicates;
+	stats._cacheHits = (int)cacheHits;
+	stats._evalsPerSecond = generationSeconds > 0.0 ? evaluations / generationSeconds : 0.0;
+	stats._offspringSeconds = offspringSeconds;
+	stats._selectionSeconds = selectionSeconds;
+	stats._seconds = elapsed();
+	_telemetry->record(stats);
+}
+
+
+
+// function to write the state of the solver to the checkpoint file of the config, the population list with the survivors on top,
+// the best tour, the random engines and the cities, so the checkpoint alone is enough to resume the run
+//
+template <typename TIdx>
+void TSPSolverT<TIdx>::writeCheckpoint(int generation) {
+	int count = _config._populationCount;
+	TSPCheckpointState state;
+	memset((void *)&state, 0, sizeof(state));
+	state._runConfig = _runConfig;
+	state._runConfig._checkpointPath = NULL;
+	state._config = _config;
+	state._config._checkpointPath = NULL;
+	state._vtxCount = _vtxCount;
+	state._metric = _vertices->_metric;
+	state._idxBytes = sizeof(TIdx);
+	state._island = _island ? _island->index() : 0;
+	state._survivors = _survivors;
+	state._generation = generation;
+	state._workerCount = _threadCount;
+	state._bestLength = _bestTour->_length;
+	state._seconds = elapsed();
+	unsigned *random = new unsigned[4 * (_threadCount + 1)];
+	_rng.getState(random);
+	for (int t = 0; t < _threadCount; t++)
+		_workers[t]._rng.getState(random + 4 * (t + 1));
+	float *lengths = new float[count];
+	for (int i = 0; i < count; i++)
+		lengths[i] = _toursPopulationList[i]->_length;
+	GCheckpointWriter file;
+	bool ok = file.begin(_config._checkpointPath)
+		&& file.section(&state, sizeof(state))
+		&& file.section(_vertices->_x, _vtxCount * sizeof(float))
+		&& file.section(_vertices->_y, _vtxCount * sizeof(float))
+		&& file.section(_bestTour->_path, _vtxCount * sizeof(unsigned))
+		&& file.section(random, 4 * (_threadCount + 1) * sizeof(unsigned))
+		&& file.section(lengths, count * sizeof(float))
+		&& file.section(NULL, 0);
+	for (int i = 0; ok && i < count; i++)
+		ok = file.write(unpackTour(i)->_path, _vtxCount * sizeof(TIdx));
+	// the fitness cache is saved too, so the resumed run reads the same lengths from it
+	//
+	if (_config._uniqueTours)
+		ok = ok && file.section(_fitnessCache.data(), _fitnessCache.bytes());
+	ok = ok && file.commit();
+	if (!ok)
+		_result._checkpointError = "can not write the checkpoint";
+	delete[] random;
+	delete[] lengths;
+}
+
+// true if the given path of a checkpoint visits every city of 0..vtxCount-1 once, seen is a scratch of vtxCount flags
+//
+template <typename T>
+bool checkpointTour(const T *path, int vtxCount, char *seen) {
+	memset(seen, 0, vtxCount);
+	for (int i = 0; i < vtxCount; i++) {
+		if ((unsigned)path[i] >= (unsigned)vtxCount || seen[path[i]])
+			return false;
+		seen[path[i]] = 1;
+	}
+	return true;
+}
+
+// true if the enums of a config read from a checkpoint are in their ranges
+//
+bool checkpointConfig(const TSPConfig &config) {
+	return (unsigned)config._crossover < G_CROSSOVER_COUNT && (unsigned)config._selection < TSP_SELECT_COUNT
+		&& (unsigned)config._localSearch <= TSP_LS_ELITE && (unsigned)config._migrationTopology <= TSP_MIGRATE_RANDOM;
+}
+
+template <typename TIdx>
+bool TSPSolverT<TIdx>::resume(const char *path, const char **error) {
+	const char *dummy;
+	if (!error)
+		error = &dummy;
+	if (!_checkpoint.open(path, error))
+		return false;
+	int count = _config._populationCount;
+	const TSPCheckpointState *state = (const TSPCheckpointState *)_checkpoint.section(TSP_CK_STATE, sizeof(TSPCheckpointState));
+	const float *x = (const float *)_checkpoint.section(TSP_CK_CITIES_X, _vtxCount * sizeof(float));
+	const float *y = (const float *)_checkpoint.section(TSP_CK_CITIES_Y, _vtxCount * sizeof(float));
+	if (!state || state->_vtxCount != _vtxCount || !x || !y || memcmp(x, _vertices->_x, _vtxCount * sizeof(float))
+		|| memcmp(y, _vertices->_y, _vtxCount * sizeof(float)) || state->_metric != _vertices->_metric)
+		*error = "the checkpoint is of other cities";
+	else if (state->_config._populationCount != count || state->_idxBytes != (int)sizeof(TIdx))
+		*error = "the checkpoint is of another population count";
+	else if (state->_island != (_island ? _island->index() : 0))
+		*error = "the checkpoint is of another island";
+	else if (state->_survivors < 1 || state->_survivors > count || state->_workerCount < 1
+		|| !_checkpoint.section(TSP_CK_BEST, _vtxCount * sizeof(unsigned))
+		|| !_checkpoint.section(TSP_CK_RANDOM, 4 * (state->_workerCount + 1) * sizeof(unsigned))
+		|| !_checkpoint.section(TSP_CK_LENGTHS, count * sizeof(float))
+		|| !_checkpoint.section(TSP_CK_GENES, (size_t)count * _vtxCount * sizeof(TIdx))
+		|| !checkpointConfig(state->_config) || !checkpointConfig(state->_runConfig))
+		*error = "corrupted checkpoint";
+	else {
+		// the best tour and every tour of the population must be a tour of the cities, the hashes, lengths
+		// and crossovers of the resumed solve index their tables by the city ids
+		//
+		const unsigned *best = (const unsigned *)_checkpoint.section(TSP_CK_BEST, _vtxCount * sizeof(unsigned));
+		const TIdx *genes = (const TIdx *)_checkpoint.section(TSP_CK_GENES, (size_t)count * _vtxCount * sizeof(TIdx));
+		char *seen = new char[_vtxCount];
+		bool ok = checkpointTour(best, _vtxCount, seen);
+		for (int i = 0; ok && i < count; i++)
+			ok = checkpointTour(genes + (size_t)i * _vtxCount, _vtxCount, seen);
+		delete[] seen;
+		if (ok)
+			return true;
+		*error = "corrupted checkpoint";
+	}
+	_checkpoint.close();
+	return false;
+}
+
+// function to restore the population, the best tour and the random engines from the checkpoint given to resume(),
+// instead of initiatePopulation(), return the generation to start with
+//
+template <typename TIdx>
+int TSPSolverT<TIdx>::restoreCheckpoint() {
+	int count = _config._populationCount;
+	const TSPCheckpointState *state = (const TSPCheckpointState *)_checkpoint.section(TSP_CK_STATE, sizeof(TSPCheckpointState));
+	const float *lengths = (const float *)_checkpoint.section(TSP_CK_LENGTHS, count * sizeof(float));
+	const TIdx *genes = (const TIdx *)_checkpoint.section(TSP_CK_GENES, (size_t)count * _vtxCount * sizeof(TIdx));
+	const unsigned *best = (const unsigned *)_checkpoint.section(TSP_CK_BEST, _vtxCount * sizeof(unsigned));
+	const unsigned *random = (const unsigned *)_checkpoint.section(TSP_CK_RANDOM, 4 * (state->_workerCount + 1) * sizeof(unsigned));
+	_population.allocate(count, 2 * _threadCount, _vtxCount, _config._packedTours);
+	_toursPopulationList = _population.tours();
+	for (int i = 0; i < count; i++) {
+		_population.write(_toursPopulationList[i], genes + (size_t)i * _vtxCount);
+		_toursPopulationList[i]->_length = lengths[i];
+		if (_config._uniqueTours)
+			_toursPopulationList[i]->_hash = _tourHash.tour(genes + (size_t)i * _vtxCount);
+	}
+	// the fitness cache of a checkpoint written with _uniqueTours, it stays empty for the others
+	//
+	if (_config._uniqueTours) {
+		const void *cache = _checkpoint.section(TSP_CK_FITNESS, _fitnessCache.bytes());
+		if (cache)
+			_fitnessCache.load(cache);
+	}
+	memcpy(_bestTour->_path, best, _vtxCount * sizeof(unsigned));
+	_bestTour->_length = state->_bestLength;
+	_survivors = state->_survivors;
+	_result._generations = state->_generation;
+	if (_publisher)
+		publishBestTour();
+	// the random sequences continue where they stopped, unless the threads count changed,
+	// then the workers get new seeds mixed with the generation
+	//
+	_rng.setState(random);
+	for (int t = 0; t < _threadCount; t++) {
+		if (state->_workerCount == _threadCount)
+			_workers[t]._rng.setState(random + 4 * (t + 1));
+		else
+			_workers[t]._rng.seed(_config._seed ? _config._seed + ((unsigned long long)(t + 1) << 32) + state->_generation : 0);
+	}
+	_start -= std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(state->_seconds));
+	int generation = state->_generation;
+	_checkpoint.close();
+	return generation;
+}
+
+
+
+// core function to compute TSP using GA based on the crossover of the config and rank-based selection,
+// the offspring of every generation is made by the worker threads, the selection runs on the solver thread
+//
+template <typename TIdx>
+const TSPResult &TSPSolverT<TIdx>::solve() {
+	_start = std::chrono::steady_clock::now();
+	startDeadline();
+	_result = TSPResult();
+	_result._bestTour = _bestTour;
+	// check if there are enough cities and chromosomes to mate
+	//
+	if (_vtxCount < 2 || _config._populationCount < 2)
+		return _result;
+	// set stop condidtion to false, the island model clears it for its islands, and update seed
+	//
+	if (!_island)
+		_stopComputing = false;
+	_rng.seed(_config._seed);
+	_parents.configure(_config);
+	if (_config._uniqueTours)
+		allocateUnique();
+	// make the worker threads and their state
+	//
+	GThreadPool pool(_config._threadCount > 0 ? _config._threadCount : GThreadPool::hardwareThreads());
+	makeWorkers(pool.threadCount());
+	// continue from the checkpoint given to resume()
+	//
+	int first = 0;
+	if (_checkpoint.isOpen())
+		first = restoreCheckpoint();
+	else {
+		// initiate random population
+		//
+		initiatePopulation(pool);
+		// set the default best tour to the first initial chromosome
+		//
+		updateBestTour(unpackTour(0));
+		// select the first list of survivors, the survivors stay sorted on the top of the population
+		//
+		_survivors = selectSurvivors(0);
+		if (_config._localSearch == TSP_LS_ELITE)
+			improveElite();
+	}
+	// iterates to generate the generations of populations
+	//
+	int lastImprovement = first;
+	for (int i = first; _config._generationIter <= 0 || i < _config._generationIter; i++) {
+		// the phases of the generation are only timed for the telemetry
+		//
+		std::chrono::steady_clock::time_point generationStart, tick;
+		if (_telemetry)
+			generationStart = tick = std::chrono::steady_clock::now();
+		// replace the loosers, from the index of the first looser to the end of the population, with the newly made children
+		//
+		_parents.prepare(_toursPopulationList, _survivors);
+		if (_config._uniqueTours)
+			resetTourSet(_toursPopulationList, _survivors);
+		pool.run(offspringTask, this);
+		if (_config._uniqueTours)
+			reconcile();
+		double offspringSeconds = _telemetry ? lap(tick) : 0.0;
+		// check if the stop was requested
+		// if so, terminate the computation
+		//
+		if (_stopComputing) {
+			// the population is still whole, the children made so far replaced some loosers, so the generation is resumed from it
+			//
+			if (_config._checkpointPath)
+				writeCheckpoint(i);
+			_result._stopped = true;
+			_result._stopReason = _deadlineReached ? TSP_STOP_DEADLINE : TSP_STOP_USER;
+			_result._seconds = elapsed();
+			return _result;
+		}
+		// exchange migrants with the other islands every migration interval
+		//
+		if (_island && _config._migrationInterval > 0 && (i + 1) % _config._migrationInterval == 0) {
+			migrate();
+			if (_telemetry)
+				tick = std::chrono::steady_clock::now();
+		}
+		// select new survivors from the newly set population
+		//
+		_survivors = selectSurvivors(_survivors);
+		if (_config._localSearch == TSP_LS_ELITE)
+			improveElite();
+		double selectionSeconds = _telemetry ? lap(tick) : 0.0;
+		// set the best solution by checking if there is the better best tour
+		// as the best tour in each generation is the first tour after sorting, so the best tour is compared with the first tour of each generation
+		//
+		bool improved = false;
+		if (_toursPopulationList[0]->_length < _bestTour->_length) {
+			updateBestTour(unpackTour(0));
+			improved = true;
+			lastImprovement = i + 1;
+		}
+		_result._generations = i + 1;
+		if (_telemetry)
+			recordGeneration(i, offspringSeconds, selectionSeconds, lap(generationStart));
+		if (_config._checkpointPath && _config._checkpointInterval > 0 && (i + 1) % _config._checkpointInterval == 0)
+			writeCheckpoint(i + 1);
+		if (_callback)
+			_callback(this, i, improved, _callbackData);
+		// check the terminations of the config between two generations
+		//
+		if (_config._targetLength > 0.0f && _bestTour->_length <= _config._targetLength)
+			_result._stopReason = TSP_STOP_TARGET;
+		else if (_config._stallGenerations > 0 && i + 1 - lastImprovement >= _config._stallGenerations)
+			_result._stopReason = TSP_STOP_STALL;
+		else if (deadlineReached())
+			_result._stopReason = TSP_STOP_DEADLINE;
+		if (_result._stopReason != TSP_STOP_GENERATIONS)
+			break;
+	}
+	_result._seconds = elapsed();
+	return _result;
+}
+
+
+
+// island model solver, runs several islands, each a TSPSolverT with its own population, on their own threads,
+// every migration interval an island sends its best tours to a neighbour island through the lock free mailboxes of the archipelago.
+// the population and the worker threads of the config are split between the islands,
+// the best tour is the best of all islands and the progress call backs of all islands are serialized
+//
+template <typename TIdx>
+class TSPIslandSolver : public TSPSolver {
+public:
+	TSPIslandSolver(const GVertexStore &vertices, const TSPConfig &config, const GDistanceOracle *dist, const GNeighbours *neighbours);
+	~TSPIslandSolver();
+
+	const TSPResult &solve();
+	void stop();
+	bool resume(const char *path, const char **error);
+	void telemetry(TSPTelemetry *sink);
+
+private:
+	static void islandTask(void *data, int thread);
+	static void islandProgress(const TSPSolver *island, int generation, bool improved, void *data);
+
+	int _islandCount;						// islands count
+	TSPArchipelago<TIdx> _archipelago;		// mailboxes and migrant packets shared by the islands
+	TSPIslandLink<TIdx> *_links;			// link of every island to the archipelago
+	TSPSolverT<TIdx> **_islands;			// island solvers
+	char **_checkpointPaths;				// checkpoint file of every island, NULL without checkpoints
+	std::mutex _progressMutex;				// serializes the best tour updates and call backs of the islands
+};
+
+
+template <typename TIdx>
+TSPIslandSolver<TIdx>::TSPIslandSolver(const GVertexStore &vertices, const TSPConfig &config, const GDistanceOracle *dist, const GNeighbours *neighbours)
+	: TSPSolver(vertices, config, dist, neighbours), _islandCount(config._islandCount),
+	_archipelago(config._islandCount, config._migrantCount > 0 ? config._migrantCount : 1, vertices._count, config._migrationTopology) {
+	int threadCount = _config._threadCount > 0 ? _config._threadCount : GThreadPool::hardwareThreads();
+	_links = new TSPIslandLink<TIdx>[_islandCount];
+	_islands = new TSPSolverT<TIdx> *[_islandCount];
+	_checkpointPaths = NULL;
+	if (_config._checkpointPath) {
+		_checkpointPaths = new char *[_islandCount];
+		for (int i = 0; i < _islandCount; i++) {
+			_checkpointPaths[i] = new char[strlen(_config._checkpointPath) + 12];
+			if (i)
+				sprintf(_checkpointPaths[i], "%s.%d", _config._checkpointPath, i);
+			else
+				strcpy(_checkpointPaths[i], _config._checkpointPath);
+		}
+	}
+	for (int i = 0; i < _islandCount; i++) {
+		TSPConfig islandConfig = _config;
+		islandConfig._islandCount = 1;
+		islandConfig._populationCount = _config._populationCount / _islandCount > 2 ? _config._populationCount / _islandCount : 2;
+		islandConfig._threadCount = threadCount / _islandCount > 1 ? threadCount / _islandCount : 1;
+		islandConfig._seed = _config._seed ? _config._seed + i : 0;
+		islandConfig._checkpointPath = _checkpointPaths ? _checkpointPaths[i] : NULL;
+		_links[i].attach(&_archipelago, i);
+		_islands[i] = new TSPSolverT<TIdx>(vertices, islandConfig, _dist, _neighbours);
+		_islands[i]->island(&_links[i], _config);
+		_islands[i]->callback(islandProgress, this);
+	}
+}
+
+template <typename TIdx>
+TSPIslandSolver<TIdx>::~TSPIslandSolver() {
+	for (int i = 0; i < _islandCount; i++)
+		delete _islands[i];
+	delete[] _islands;
+	delete[] _links;
+	if (_checkpointPaths) {
+		for (int i = 0; i < _islandCount; i++)
+			delete[] _checkpointPaths[i];
+		delete[] _checkpointPaths;
+	}
+}
+
+template <typename TIdx>
+void TSPIslandSolver<TIdx>::stop() {
+	_stopComputing = true;
+	for (int i = 0; i < _islandCount; i++)
+		_islands[i]->stop();
+}
+
+// the islands share the sink, their records carry their island index
+//
+template <typename TIdx>
+void TSPIslandSolver<TIdx>::telemetry(TSPTelemetry *sink) {
+	_telemetry = sink;
+	for (int i = 0; i < _islandCount; i++)
+		_islands[i]->telemetry(sink);
+}
+
+// every island resumes from its own checkpoint, named as the islands write them,
+// the migrants on their way between the islands at the checkpoints are lost
+//
+template <typename TIdx>
+bool TSPIslandSolver<TIdx>::resume(const char *path, const char **error) {
+	char *islandPath = new char[strlen(path) + 12];
+	bool ok = true;
+	for (int i = 0; ok && i < _islandCount; i++) {
+		if (i)
+			sprintf(islandPath, "%s.%d", path, i);
+		else
+			strcpy(islandPath, path);
+		ok = _islands[i]->resume(islandPath, error);
+	}
+	delete[] islandPath;
+	return ok;
+}
+
+template <typename TIdx>
+void TSPIslandSolver<TIdx>::islandTask(void *data, int thread) {
+	TSPIslandSolver *self = (TSPIslandSolver *)data;
+	if (!self->_stopComputing)
+		self->_islands[thread]->solve();
+}
+
+// progress call back of the islands, every improvement of an island is checked against the best tour of all islands,
+// the generations without improvement are only reported by the first island
+//
+template <typename TIdx>
+void TSPIslandSolver<TIdx>::islandProgress(const TSPSolver *island, int generation, bool improved, void *data) {
+	TSPIslandSolver *self = (TSPIslandSolver *)data;
+	std::lock_guard<std::mutex> lock(self->_progressMutex);
+	// the target reached by one island ends the whole solve, its best tour may be that of its initial population
+	//
+	if (self->_config._targetLength > 0.0f && island->bestTour()->_length <= self->_config._targetLength) {
+		self->_result._stopReason = TSP_STOP_TARGET;
+		self->stop();
+	}
+	if (improved && island->bestTour()->_length < self->_bestTour->_length)
+		self->updateBestTour(island->bestTour());
+	else if (island != self->_islands[0])
+		return;
+	else
+		improved = false;
+	if (self->_callback)
+		self->_callback(self, generation, improved, self->_callbackData);
+}
+
+// run all islands, one per pool thread, each island runs its own worker pool
+//
+template <typename TIdx>
+const TSPResult &TSPIslandSolver<TIdx>::solve() {
+	_start = std::chrono::steady_clock::now();
+	_result = TSPResult();
+	_result._bestTour = _bestTour;
+	_bestTour->_length = __INF_LEN_TOUR__;
+	// the islands do not clear their stop flags, so a stop() of another island before an island starts is not lost
+	//
+	_stopComputing = false;
+	for (int i = 0; i < _islandCount; i++)
+		_islands[i]->_stopComputing = false;
+	startDeadline();
+	GThreadPool pool(_islandCount);
+	pool.run(islandTask, this);
+	// an island may hold its best tour since the initial population, without any improvement call back
+	//
+	for (int i = 0; i < _islandCount; i++) {
+		const TSPResult &r = _islands[i]->result();
+		if (r._bestTour && r._bestTour->_length < _bestTour->_length)
+			updateBestTour(r._bestTour);
+		if (r._generations > _result._generations)
+			_result._generations = r._generations;
+	}
+	// every island ends by its own terminations, the solve ends with the first island unless the target or stop() ended all
+	//
+	if (_result._stopReason != TSP_STOP_TARGET)
+		_result._stopReason = _stopComputing ? TSP_STOP_USER : _islands[0]->result()._stopReason;
+	_result._stopped = _stopComputing || _islands[0]->result()._stopped;
+	_result._seconds = elapsed();
+	return _result;
+}
+
+
+
+bool TSPSolver::readCheckpoint(const char *path, GVertexStore &vertices, TSPConfig &config, const char **error) {
+	const char *dummy;
+	if (!error)
+		error = &dummy;
+	GCheckpoint file;
+	if (!file.open(path, error))
+		return false;
+	const TSPCheckpointState *state = (const TSPCheckpointState *)file.section(TSP_CK_STATE, sizeof(TSPCheckpointState));
+	const float *x = state ? (const float *)file.section(TSP_CK_CITIES_X, state->_vtxCount * sizeof(float)) : NULL;
+	const float *y = state ? (const float *)file.section(TSP_CK_CITIES_Y, state->_vtxCount * sizeof(float)) : NULL;
+	if (!x || !y || state->_vtxCount < 2 || (unsigned)state->_metric > G_METRIC_ATT || !checkpointConfig(state->_runConfig)) {
+		*error = "corrupted checkpoint";
+		return false;
+	}
+	vertices.resize(state->_vtxCount);
+	memcpy(vertices._x, x, state->_vtxCount * sizeof(float));
+	memcpy(vertices._y, y, state->_vtxCount * sizeof(float));
+	vertices._metric = (GMetric)state->_metric;
+	config = state->_runConfig;
+	config._checkpointPath = NULL;
+	return true;
+}
+
+
+
+// make the solver instance with the given tour index type, a single population or the island model
+//
+template <typename TIdx>
+TSPSolver *makeSolver(const GVertexStore &vertices, const TSPConfig &config, const GDistanceOracle *dist, const GNeighbours *neighbours) {
+	if (config._islandCount > 1)
+		return new TSPIslandSolver<TIdx>(vertices, config, dist, neighbours);
+	return new TSPSolverT<TIdx>(vertices, config, dist, neighbours);
+}
+
+// fixed size solver of the small instances, defined in SmallSolver.h, NULL if it does not support the cities count or the config
+//
+TSPSolver *makeSmallSolver(const GVertexStore &vertices, const TSPConfig &config, const GDistanceOracle *dist, const GNeighbours *neighbours);
+
+// make the solver instance with the narrowest tour index type able to hold the cities count,
+// or the fixed size solver for the small instances
+//
+TSPSolver *TSPSolver::create(const GVertexStore &vertices, const TSPConfig &config, const GDistanceOracle *dist, const GNeighbours *neighbours) {
+	if (TSPSolver *solver = makeSmallSolver(vertices, config, dist, neighbours))
+		return solver;
+	if (vertices._count <= __IDX8_MAX_VTX__)
+		return makeSolver<unsigned char>(vertices, config, dist, neighbours);
+	if (vertices._count <= __IDX16_MAX_VTX__)
+		return makeSolver<unsigned short>(vertices, config, dist, neighbours);
+	return makeSolver<unsigned>(vertices, config, dist, neighbours);
+}
+
+
+
+#include "SmallSolver.h"
+
+
+
+#endif /*__TSPSOLVER_H__*/
@@ -0,0 +1,112 @@
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+
+// record of one generation of a solver
+//
+struct TSPGenerationStats {
+	int _generation;			// index of the generation, from 0
+	int _island;				// island of the solver, 0 without the island model
+	float _best;				// shortest tour of the population after the selection
+	float _mean;				// mean tour length of the population
+	float _worst;				// longest tour of the population
+	int _crossovers;			// crossovers of the generation, each makes one or two children
+	int _mutations;				// mutations of the generation
+	int _evaluations;			// full tour length evaluations of the generation
+	int _duplicates;			// children found to be tours of the population already, with _uniqueTours
+	int _cacheHits;				// children lengths read from the fitness cache instead of evaluated, with _uniqueTours
+	double _evalsPerSecond;		// evaluations per second of the generation wall time
+	double _offspringSeconds;	// time spent making the children, crossover, mutation and local search of the children
+	double _selectionSeconds;	// time spent sorting and selecting the survivors, and improving the elite
+	double _seconds;			// wall time of the solve at the end of the generation
+};
+
+// telemetry call back, called with every record, from the solver thread of the island for the island model
+//
+typedef void (*TSPTelemetryCallback)(const TSPGenerationStats &stats, void *data);
+
+
+// format of the telemetry file
+//
+enum TSPTelemetryFormat {
+	TSP_TELEMETRY_JSON,		// one JSON object per line
+	TSP_TELEMETRY_CSV		// a header line, then one comma separated line per record
+};
+
+
+// sink of the generation records of the solvers it is given to, written to a file and/or passed to a call back.
+// a solver without sink does not time or aggregate anything, the records are only made when a sink is set.
+// the islands of the island model share the sink, so the records are written under a lock
+//
+class TSPTelemetry {
+public:
+	TSPTelemetry() : _file(NULL), _ownFile(false), _format(TSP_TELEMETRY_JSON), _callback(NULL), _callbackData(NULL) {}
+	~TSPTelemetry() { close(); }
+
+	bool open(const char *path, TSPTelemetryFormat format);		// write the records to the given file, "-" is the standard output
+	void close();
+	void callback(TSPTelemetryCallback cb, void *data) { _callback = cb; _callbackData = data; }
+
+	void record(const TSPGenerationStats &stats);
+
+private:
+	TSPTelemetry(const TSPTelemetry &);
+	TSPTelemetry &operator=(const TSPTelemetry &);
+
+	FILE *_file;					// telemetry file, NULL if the records are not written
+	bool _ownFile;					// the file was opened by open(), so it is closed by close()
+	TSPTelemetryFormat _format;		// format of the file
+	TSPTelemetryCallback _callback;
+	void *_callbackData;
+	std::mutex _mutex;				// serializes the records of the islands
+};
+
+
+bool TSPTelemetry::open(const char *path, TSPTelemetryFormat format) {
+	close();
+	_format = format;
+	if (!strcmp(path, "-"))
+		_file = stdout;
+	else {
+		_file = fopen(path, "w");
+		if (!_file)
+			return false;
+		_ownFile = true;
+	}
+	if (_format == TSP_TELEMETRY_CSV)
+		fprintf(_file, "generation,island,best,mean,worst,crossovers,mutations,evaluations,duplicates,cache_hits,evals_per_sec,offspring_s,selection_s,elapsed_s\n");
+	return true;
+}
+
+void TSPTelemetry::close() {
+	if (_ownFile)
+		fclose(_file);
+	else if (_file)
+		fflush(_file);
+	_file = NULL;
+	_ownFile = false;
+}
+
+void TSPTelemetry::record(const TSPGenerationStats &stats) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_file) {
+		const char *format = _format == TSP_TELEMETRY_CSV
+			? "%d,%d,%.3f,%.3f,%.3f,%d,%d,%d,%d,%d,%.0f,%.6f,%.6f,%.6f\n"
+			: "{\"generation\":%d,\"island\":%d,\"best\":%.3f,\"mean\":%.3f,\"worst\":%.3f,\"crossovers\":%d,\"mutations\":%d,"
+			"\"evaluations\":%d,\"duplicates\":%d,\"cache_hits\":%d,\"evals_per_sec\":%.0f,\"offspring_s\":%.6f,\"selection_s\":%.6f,\"elapsed_s\":%.6f}\n";
+		fprintf(_file, format, stats._generation, stats._island, stats._best, stats._mean, stats._worst, stats._crossovers,
+			stats._mutations, stats._evaluations, stats._duplicates, stats._cacheHits, stats._evalsPerSecond, stats._offspringSeconds, stats._selectionSeconds, stats._seconds);
+	}
+	if (_callback)
+		_callback(stats, _callbackData);
+}
+
+
+
+#endif /*__TELEMETRY_H__*/
@@ -0,0 +1,298 @@
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+
+// task of the thread pool, called once per thread with the index of the thread
+//
+typedef void (*GPoolTask)(void *data, int thread);
+
+
+// pool of worker threads kept alive for a whole solve,
+// run() hands the same task to every thread, the calling thread is thread 0, and blocks until all threads are done
+//
+class GThreadPool {
+public:
+	explicit GThreadPool(int threadCount);
+	~GThreadPool();
+
+	int threadCount() const { return _threadCount; }
+	void run(GPoolTask task, void *data);
+
+	// threads count of the machine, 1 if unknown
+	//
+	static int hardwareThreads() {
+		int n = (int)std::thread::hardware_concurrency();
+		return n > 0 ? n : 1;
+	}
+
+private:
+	GThreadPool(const GThreadPool &);
+	GThreadPool &operator=(const GThreadPool &);
+
+	void workerLoop(int thread);
+
+	int _threadCount;				// threads count, including the calling thread
+	std::thread *_threads;			// worker threads 1..threadCount-1
+	std::mutex _mutex;
+	std::condition_variable _wake;	// signals a new task to the workers
+	std::condition_variable _done;	// signals the completion of the last worker
+	GPoolTask _task;				// current task
+	void *_data;					// current task data
+	unsigned _round;				// incremented for every run()
+	int _pending;					// workers still running the current task
+	bool _quit;						// set when the pool is destroyed
+};
+
+
+GThreadPool::GThreadPool(int threadCount)
+	: _threadCount(threadCount < 1 ? 1 : threadCount), _threads(NULL), _task(NULL), _data(NULL), _round(0), _pending(0), _quit(false) {
+	if (_threadCount > 1) {
+		_threads = new std::thread[_threadCount - 1];
+		for (int i = 1; i < _threadCount; i++)
+			_threads[i - 1] = std::thread(&GThreadPool::workerLoop, this, i);
+	}
+}
+
+GThreadPool::~GThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_wake.notify_all();
+	for (int i = 1; i < _threadCount; i++)
+		_threads[i - 1].join();
+	delete[] _threads;
+}
+
+void GThreadPool::run(GPoolTask task, void *data) {
+	if (_threadCount == 1) {
+		task(data, 0);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_task = task;
+		_data = data;
+		_pending = _threadCount - 1;
+		_round++;
+	}
+	_wake.notify_all();
+	task(data, 0);
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (_pending)
+		_done.wait(lock);
+}
+
+void GThreadPool::workerLoop(int thread) {
+	unsigned round = 0;
+	for (;;) {
+		GPoolTask task;
+		void *data;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			while (!_quit && _round == round)
+				_wake.wait(lock);
+			if (_quit)
+				return;
+			round = _round;
+			task = _task;
+			data = _data;
+		}
+		task(data, thread);
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (--_pending == 0)
+			_done.notify_one();
+	}
+}
+
+
+
+// pool of worker threads running independent tasks, every submitted task runs once, on one of the threads.
+// every thread has its own queue and the submitted tasks are dealt to the queues in turn, a thread runs the oldest task
+// of its own queue, so the tasks of a stream start about in submission order, and steals the newest task of another queue
+// when its own is empty, so the threads stay busy whatever the lengths of the tasks. the calling thread only submits and waits.
+// a queue has its own lock and nothing else is locked to submit or take a task, a thread finding every queue empty
+// parks on a condition variable and a submit only wakes one when a thread is parked
+//
+class GTaskPool {
+public:
+	explicit GTaskPool(int threadCount);
+	~GTaskPool();		// run the tasks still queued, then join the threads
+
+	int threadCount() const { return _threadCount; }
+	void submit(GPoolTask task, void *data);		// queue a task, it is called with the index of the thread running it
+	void wait();									// block until every submitted task is done
+
+private:
+	GTaskPool(const GTaskPool &);
+	GTaskPool &operator=(const GTaskPool &);
+
+	struct GTaskItem {
+		GPoolTask _task;
+		void *_data;
+	};
+
+	// circular task queue of one thread, grown when it is full, its count is read without the lock to skip it when empty
+	//
+	struct GTaskQueue {
+		GTaskQueue() : _items(NULL), _capacity(0), _head(0), _count(0) {}
+		~GTaskQueue() { delete[] _items; }
+		void push(const GTaskItem &item);
+		bool popBack(GTaskItem &item);
+		bool popFront(GTaskItem &item);
+
+		std::mutex _mutex;
+		GTaskItem *_items;
+		int _capacity;
+		int _head;				// index of the oldest task
+		std::atomic<int> _count;	// tasks in the queue, written under the lock
+	};
+
+	bool take(int thread, GTaskItem &item);
+	bool queued() const;
+	void workerLoop(int thread);
+
+	int _threadCount;				// threads count
+	std::thread *_threads;			// worker threads
+	GTaskQueue *_queues;			// queue of every thread
+	std::atomic<unsigned> _next;	// submissions count, picks the queue of the next task
+	std::mutex _mutex;				// guards the parking of the threads and the wait for the tasks
+	std::condition_variable _wake;	// signals a new task, or the end, to the parked threads
+	std::condition_variable _done;	// signals that every task is done
+	std::atomic<int> _sleepers;		// threads parked or about to park, written under _mutex
+	std::atomic<int> _pending;		// tasks submitted and not done
+	bool _quit;						// set when the pool is destroyed
+};
+
+
+void GTaskPool::GTaskQueue::push(const GTaskItem &item) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_count == _capacity) {
+		int capacity = _capacity ? 2 * _capacity : 16;
+		GTaskItem *items = new GTaskItem[capacity];
+		for (int i = 0; i < _count; i++)
+			items[i] = _items[(_head + i) % _capacity];
+		delete[] _items;
+		_items = items;
+		_capacity = capacity;
+		_head = 0;
+	}
+	_items[(_head + _count++) % _capacity] = item;
+}
+
+bool GTaskPool::GTaskQueue::popBack(GTaskItem &item) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_count)
+		return false;
+	item = _items[(_head + --_count) % _capacity];
+	return true;
+}
+
+bool GTaskPool::GTaskQueue::popFront(GTaskItem &item) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_count)
+		return false;
+	item = _items[_head];
+	_head = (_head + 1) % _capacity;
+	_count--;
+	return true;
+}
+
+
+GTaskPool::GTaskPool(int threadCount)
+	: _threadCount(threadCount < 1 ? 1 : threadCount), _next(0), _sleepers(0), _pending(0), _quit(false) {
+	_queues = new GTaskQueue[_threadCount];
+	_threads = new std::thread[_threadCount];
+	for (int i = 0; i < _threadCount; i++)
+		_threads[i] = std::thread(&GTaskPool::workerLoop, this, i);
+}
+
+GTaskPool::~GTaskPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_wake.notify_all();
+	for (int i = 0; i < _threadCount; i++)
+		_threads[i].join();
+	delete[] _threads;
+	delete[] _queues;
+}
+
+// queue the task, then wake a parked thread if there is one. the task count of the queue is written before the sleepers
+// are read, and a parking thread counts itself before it reads the task counts, so either the parking thread sees the task
+// or the submit sees the sleeper, and then waits for it to be parked to wake it
+//
+void GTaskPool::submit(GPoolTask task, void *data) {
+	GTaskItem item = { task, data };
+	_pending++;
+	_queues[_next++ % _threadCount].push(item);
+	if (_sleepers.load()) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_wake.notify_one();
+	}
+}
+
+void GTaskPool::wait() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (_pending.load())
+		_done.wait(lock);
+}
+
+// take a task, the oldest one of the own queue or the newest one of the next queue which has any,
+// the empty queues are skipped without their locks
+//
+bool GTaskPool::take(int thread, GTaskItem &item) {
+	if (_queues[thread]._count.load(std::memory_order_relaxed) && _queues[thread].popFront(item))
+		return true;
+	for (int i = 1; i < _threadCount; i++) {
+		GTaskQueue &queue = _queues[(thread + i) % _threadCount];
+		if (queue._count.load(std::memory_order_relaxed) && queue.popBack(item))
+			return true;
+	}
+	return false;
+}
+
+// true if any queue holds a task
+//
+bool GTaskPool::queued() const {
+	for (int i = 0; i < _threadCount; i++)
+		if (_queues[i]._count.load())
+			return true;
+	return false;
+}
+
+// a thread runs tasks as long as it finds any, then parks until a submit wakes it, it ends once the pool is destroyed
+// and every queue is empty
+//
+void GTaskPool::workerLoop(int thread) {
+	for (;;) {
+		GTaskItem item;
+		if (take(thread, item)) {
+			item._task(item._data, thread);
+			if (--_pending == 0) {
+				std::lock_guard<std::mutex> lock(_mutex);
+				_done.notify_all();
+			}
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(_mutex);
+		_sleepers++;
+		while (!_quit && !queued())
+			_wake.wait(lock);
+		_sleepers--;
+		if (_quit && !queued())
+			return;
+	}
+}
+
+
+
+#endif /*__THREADPOOL_H__*/
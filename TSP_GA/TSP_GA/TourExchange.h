@@ -0,0 +1,88 @@
+#ifndef __TOUREXCHANGE_H__
+#define __TOUREXCHANGE_H__
+
+
+
+#include <atomic>
+#include <cfloat>
+
+#define __EXCHANGE_FRESH__ 4		// flag of the middle buffer index, set when the writer published it and the reader did not take it yet
+
+
+// copy of a best tour published by a solver
+//
+struct GTourSnapshot {
+	GTourSnapshot() : _path(NULL), _length(FLT_MAX), _generation(0), _serial(0) {}
+	unsigned *_path;			// city ids of the tour
+	float _length;				// tour length
+	int _generation;			// generations completed when the tour was published
+	unsigned _serial;			// publication number, 0 if nothing was published in this buffer yet
+};
+
+
+// lock free exchange of the best tour between one writer, the solver, and one reader, the UI,
+// a triple buffer: the writer fills its back buffer and swaps it with the middle one, the reader swaps its front buffer
+// with the middle one when a fresher tour is there. the swaps are single atomic exchanges, so neither side ever waits,
+// and the reader keeps its front buffer until its next latest() call, whatever the writer does meanwhile
+//
+class GTourExchange {
+public:
+	GTourExchange() : _vtxCount(0), _back(0), _front(1), _serial(0) { _middle.store(2); }
+	~GTourExchange() { clear(); }
+
+	void allocate(int vtxCount);		// (re)allocate the buffers for tours of vtxCount cities, neither side may use the exchange meanwhile
+	void clear();
+
+	int vtxCount() const { return _vtxCount; }
+
+	// writer side, fill the back buffer then publish it
+	//
+	GTourSnapshot *back() { return &_snapshots[_back]; }
+	void publish() {
+		_snapshots[_back]._serial = ++_serial;
+		_back = _middle.exchange(_back | __EXCHANGE_FRESH__, std::memory_order_acq_rel) & 3;
+	}
+
+	// reader side, the latest published tour, its serial is 0 if nothing was published yet
+	//
+	const GTourSnapshot *latest() {
+		if (_middle.load(std::memory_order_relaxed) & __EXCHANGE_FRESH__)
+			_front = _middle.exchange(_front, std::memory_order_acq_rel) & 3;
+		return &_snapshots[_front];
+	}
+
+private:
+	GTourExchange(const GTourExchange &);
+	GTourExchange &operator=(const GTourExchange &);
+
+	GTourSnapshot _snapshots[3];		// the three buffers
+	int _vtxCount;						// cities count of the tours
+	int _back;							// buffer owned by the writer
+	int _front;							// buffer owned by the reader
+	std::atomic<int> _middle;			// buffer in between, with the fresh flag
+	unsigned _serial;					// publications count of the writer
+};
+
+
+void GTourExchange::allocate(int vtxCount) {
+	clear();
+	_vtxCount = vtxCount;
+	for (int i = 0; i < 3; i++)
+		_snapshots[i]._path = new unsigned[_vtxCount];
+}
+
+void GTourExchange::clear() {
+	for (int i = 0; i < 3; i++) {
+		delete[] _snapshots[i]._path;
+		_snapshots[i] = GTourSnapshot();
+	}
+	_vtxCount = 0;
+	_back = 0;
+	_front = 1;
+	_middle.store(2);
+	_serial = 0;
+}
+
+
+
+#endif /*__TOUREXCHANGE_H__*/
@@ -0,0 +1,212 @@
+#ifndef __TOURHASH_H__
+#define __TOURHASH_H__
+
+
+
+#include <cstring>
+#include <atomic>
+
+#include "Random.h"
+
+#define __HASH_KEY_SEED__ 0x5DEECE66DULL	// seed of the city keys, fixed so a tour has the same hash in every solve
+#define __HASH_EDGE_MIX__ 0xBF58476D1CE4E5B9ULL	// odd multiplier mixing the keys of an edge
+#define __TOUR_SET_SLOTS__ 2				// slots of the tour set per tour, at least, so it is at most half full
+#define __FITNESS_CACHE_SLOTS__ 4			// slots of the fitness cache per tour of the population
+#define __FITNESS_CACHE_MIN_BITS__ 10		// log2 of the fewest slots of the fitness cache
+#define __FITNESS_CACHE_MAX_BITS__ 22		// log2 of the most slots of the fitness cache
+
+
+// hash of a tour independent of its first city and of its direction, the XOR of the hashes of its edges,
+// an edge hash mixes the random keys of its two cities symmetrically. a move only changes the hashes of the edges
+// it removes and adds, so the hash of a swap mutation is updated from 8 edge hashes
+//
+class GTourHash {
+public:
+	GTourHash() : _keys(NULL), _vtxCount(0) {}
+	~GTourHash() { delete[] _keys; }
+
+	void build(int vtxCount);		// draw the keys of the cities
+
+	unsigned long long edge(int a, int b) const {
+		unsigned long long z = (_keys[a] ^ _keys[b]) * __HASH_EDGE_MIX__;
+		return z ^ (z >> 31);
+	}
+
+	// hash of the tour of vtxCount cities, the edge closing it included
+	//
+	template <typename TIdx>
+	unsigned long long tour(const TIdx *path) const {
+		unsigned long long h = edge(path[_vtxCount - 1], path[0]);
+		for (int i = 0; i < _vtxCount - 1; i++)
+			h ^= edge(path[i], path[i + 1]);
+		return h;
+	}
+
+	// hash change of swapping the cities at the positions i and j, XORed into the hash of the tour,
+	// the edges shared by the removed and the added ones, when the positions are adjacent, cancel out
+	//
+	template <typename TIdx>
+	unsigned long long swapDelta(const TIdx *path, int i, int j) const {
+		if (i == j)
+			return 0;
+		int n = _vtxCount;
+		int a = path[i], b = path[j];
+		int pi = path[i == 0 ? n - 1 : i - 1], ni = path[i == n - 1 ? 0 : i + 1];
+		int pj = path[j == 0 ? n - 1 : j - 1], nj = path[j == n - 1 ? 0 : j + 1];
+		return edge(pi, a) ^ edge(a, ni) ^ edge(pj, b) ^ edge(b, nj)
+			^ edge(pi, b) ^ edge(b, ni) ^ edge(pj, a) ^ edge(a, nj);
+	}
+
+private:
+	GTourHash(const GTourHash &);
+	GTourHash &operator=(const GTourHash &);
+
+	unsigned long long *_keys;		// random key of every city
+	int _vtxCount;					// cities count
+};
+
+
+void GTourHash::build(int vtxCount) {
+	delete[] _keys;
+	_vtxCount = vtxCount;
+	_keys = new unsigned long long[_vtxCount];
+	GRandom rng(__HASH_KEY_SEED__);
+	for (int i = 0; i < _vtxCount; i++)
+		_keys[i] = (unsigned long long)rng.next() << 32 | rng.next();
+}
+
+
+
+// set of the tour hashes of a population, open addressing with linear probing, the hash 0 marks an empty slot.
+// the threads may insert concurrently, a slot is claimed by a compare and swap, so of two equal tours only one gets in
+//
+class GTourSet {
+public:
+	GTourSet() : _slots(NULL), _mask(0) {}
+	~GTourSet() { delete[] _slots; }
+
+	void allocate(int count);		// room for count tours
+	void reset();					// empty the set
+
+	// true if the hash is in the set
+	//
+	bool contains(unsigned long long hash) const {
+		if (!hash)
+			hash = 1;
+		for (unsigned i = (unsigned)(hash >> 32) & _mask;; i = (i + 1) & _mask) {
+			unsigned long long slot = _slots[i].load(std::memory_order_relaxed);
+			if (slot == hash)
+				return true;
+			if (!slot)
+				return false;
+		}
+	}
+
+	// insert the hash, return false if it is already in the set
+	//
+	bool insert(unsigned long long hash) {
+		if (!hash)
+			hash = 1;
+		for (unsigned i = (unsigned)(hash >> 32) & _mask;; i = (i + 1) & _mask) {
+			unsigned long long slot = _slots[i].load(std::memory_order_relaxed);
+			if (slot == hash)
+				return false;
+			if (!slot) {
+				if (_slots[i].compare_exchange_strong(slot, hash, std::memory_order_relaxed))
+					return true;
+				if (slot == hash)
+					return false;
+			}
+		}
+	}
+
+private:
+	GTourSet(const GTourSet &);
+	GTourSet &operator=(const GTourSet &);
+
+	std::atomic<unsigned long long> *_slots;	// tour hashes, 0 in the empty slots
+	unsigned _mask;								// slots count - 1, a power of 2 - 1
+};
+
+
+void GTourSet::allocate(int count) {
+	delete[] _slots;
+	unsigned slots = 1;
+	while (slots < (unsigned)count * __TOUR_SET_SLOTS__)
+		slots <<= 1;
+	_slots = new std::atomic<unsigned long long>[slots];
+	_mask = slots - 1;
+	reset();
+}
+
+void GTourSet::reset() {
+	for (unsigned i = 0; i <= _mask; i++)
+		_slots[i].store(0, std::memory_order_relaxed);
+}
+
+
+
+// lengths of the tours already evaluated, by tour hash, a direct mapped cache read by the worker threads,
+// the low bits of the hash pick the slot and its entry keeps the high half as tag and the length bits, so a hit only matches
+// 42 to 54 bits of the hash, the slot bits and the tag. the tours of one hash are the rotations and reversals of one cycle,
+// a hit gives the length of the one stored, which may differ from the length summed for another in the last bits.
+// a colliding tour overwrites the entry, the cache forgets but never grows
+//
+class GFitnessCache {
+public:
+	GFitnessCache() : _slots(NULL), _mask(0) {}
+	~GFitnessCache() { delete[] _slots; }
+
+	void allocate(int count);		// empty cache sized for a population of count tours
+
+	// entries of the cache, to save them in a checkpoint and load them back into a cache of the same size
+	//
+	size_t bytes() const { return (_mask + 1) * sizeof(unsigned long long); }
+	const void *data() const { return _slots; }
+	void load(const void *data) {
+		const unsigned long long *entries = (const unsigned long long *)data;
+		for (unsigned i = 0; i <= _mask; i++)
+			_slots[i].store(entries[i], std::memory_order_relaxed);
+	}
+
+	// length of the tour of the given hash, return false if it is not cached
+	//
+	bool find(unsigned long long hash, float &length) const {
+		unsigned long long entry = _slots[hash & _mask].load(std::memory_order_relaxed);
+		unsigned tag = (unsigned)(hash >> 32);
+		if ((unsigned)(entry >> 32) != tag || tag == ~0u)
+			return false;
+		unsigned bits = (unsigned)entry;
+		memcpy(&length, &bits, sizeof(float));
+		return true;
+	}
+
+	void store(unsigned long long hash, float length) {
+		unsigned bits;
+		memcpy(&bits, &length, sizeof(float));
+		_slots[hash & _mask].store((hash >> 32) << 32 | bits, std::memory_order_relaxed);
+	}
+
+private:
+	GFitnessCache(const GFitnessCache &);
+	GFitnessCache &operator=(const GFitnessCache &);
+
+	std::atomic<unsigned long long> *_slots;	// entries, all bits set in an empty one
+	unsigned _mask;								// slots count - 1, a power of 2 - 1
+};
+
+
+void GFitnessCache::allocate(int count) {
+	delete[] _slots;
+	int bits = __FITNESS_CACHE_MIN_BITS__;
+	while (bits < __FITNESS_CACHE_MAX_BITS__ && (1LL << bits) < (long long)count * __FITNESS_CACHE_SLOTS__)
+		bits++;
+	_slots = new std::atomic<unsigned long long>[1 << bits];
+	_mask = (1u << bits) - 1;
+	for (unsigned i = 0; i <= _mask; i++)
+		_slots[i].store(~0ULL, std::memory_order_relaxed);
+}
+
+
+
+#endif /*__TOURHASH_H__*/
@@ -0,0 +1,227 @@
+#ifndef __TOURLENGTH_H__
+#define __TOURLENGTH_H__
+
+
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define __SIMD_X86__
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// the AVX2 kernels are compiled for AVX2 whatever the build flags, and only called when the CPU has it
+//
+#if defined(__SIMD_X86__) && (defined(__GNUC__) || defined(__clang__))
+#define __TARGET_AVX2__ __attribute__((target("avx2")))
+#else
+#define __TARGET_AVX2__
+#endif
+
+
+// instruction set of the tour length kernels
+//
+enum GSimdLevel {
+	G_SIMD_SCALAR,		// one edge at a time, every CPU
+	G_SIMD_SSE,			// 4 edges at a time, loads one by one
+	G_SIMD_AVX2			// 8 edges at a time, gathers by tour index
+};
+
+
+// best level supported by the CPU running the program, and by its OS for the AVX registers
+//
+GSimdLevel detectSimdLevel() {
+#if defined(__SIMD_X86__) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+	bool avx2 = false;
+	if (osAvx && maxLeaf >= 7) {
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+	return avx2 ? G_SIMD_AVX2 : sse2 ? G_SIMD_SSE : G_SIMD_SCALAR;
+#elif defined(__SIMD_X86__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return G_SIMD_AVX2;
+	return __builtin_cpu_supports("sse2") ? G_SIMD_SSE : G_SIMD_SCALAR;
+#else
+	return G_SIMD_SCALAR;
+#endif
+}
+
+const char *simdLevelName(GSimdLevel level) {
+	return level == G_SIMD_AVX2 ? "avx2" : level == G_SIMD_SSE ? "sse" : "scalar";
+}
+
+GSimdLevel __simdLevel = detectSimdLevel();		// level used by the tour evaluations, detected once at start up
+
+
+
+// scalar kernels, also the tails of the vector kernels
+//
+template <typename TIdx>
+float coordEdgesScalar(const float *x, const float *y, const TIdx *tour, int from, int to) {
+	float length = 0.0f;
+	for (int i = from; i < to; i++) {
+		float dx = x[tour[i]] - x[tour[i + 1]];
+		float dy = y[tour[i]] - y[tour[i + 1]];
+		length += sqrtf(dx * dx + dy * dy);
+	}
+	return length;
+}
+
+template <typename TIdx>
+float matrixEdgesScalar(const float *matrix, int vtxCount, const TIdx *tour, int from, int to) {
+	float length = 0.0f;
+	for (int i = from; i < to; i++)
+		length += matrix[tour[i] * vtxCount + tour[i + 1]];
+	return length;
+}
+
+
+#ifdef __SIMD_X86__
+
+float horizontalSum(__m128 v) {
+	v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+	return _mm_cvtss_f32(v);
+}
+
+// SSE kernels, SSE has no gather, the 4 lanes are loaded one by one, the sums and the square roots are vectorized
+// and the 4 partial sums break the dependency chain of the scalar loop
+//
+template <typename TIdx>
+float coordEdgesSSE(const float *x, const float *y, const TIdx *tour, int from, int to) {
+	__m128 sum = _mm_setzero_ps();
+	int i = from;
+	for (; i + 4 <= to; i += 4) {
+		const TIdx *t = tour + i;
+		__m128 dx = _mm_sub_ps(_mm_setr_ps(x[t[0]], x[t[1]], x[t[2]], x[t[3]]), _mm_setr_ps(x[t[1]], x[t[2]], x[t[3]], x[t[4]]));
+		__m128 dy = _mm_sub_ps(_mm_setr_ps(y[t[0]], y[t[1]], y[t[2]], y[t[3]]), _mm_setr_ps(y[t[1]], y[t[2]], y[t[3]], y[t[4]]));
+		sum = _mm_add_ps(sum, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy))));
+	}
+	return horizontalSum(sum) + coordEdgesScalar(x, y, tour, i, to);
+}
+
+template <typename TIdx>
+float matrixEdgesSSE(const float *matrix, int vtxCount, const TIdx *tour, int from, int to) {
+	__m128 sum = _mm_setzero_ps();
+	int i = from;
+	for (; i + 4 <= to; i += 4) {
+		const TIdx *t = tour + i;
+		sum = _mm_add_ps(sum, _mm_setr_ps(matrix[t[0] * vtxCount + t[1]], matrix[t[1] * vtxCount + t[2]],
+			matrix[t[2] * vtxCount + t[3]], matrix[t[3] * vtxCount + t[4]]));
+	}
+	return horizontalSum(sum) + matrixEdgesScalar(matrix, vtxCount, tour, i, to);
+}
+
+
+// 8 tour indices widened to 32 bits, for every index type
+//
+__TARGET_AVX2__ __m256i loadIndices(const unsigned char *t) { return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)t)); }
+__TARGET_AVX2__ __m256i loadIndices(const unsigned short *t) { return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)t)); }
+__TARGET_AVX2__ __m256i loadIndices(const unsigned *t) { return _mm256_loadu_si256((const __m256i *)t); }
+
+__TARGET_AVX2__ float horizontalSum(__m256 v) {
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+	return _mm_cvtss_f32(s);
+}
+
+// AVX2 kernel on the coordinates, the positions of 8 cities are gathered once,
+// the second ends of the 8 edges are the same cities shifted by one lane, with the first city of the next block
+//
+template <typename TIdx>
+__TARGET_AVX2__ float coordEdgesAVX2(const float *x, const float *y, const TIdx *tour, int from, int to) {
+	int i = from;
+	__m256 sum = _mm256_setzero_ps();
+	if (i + 16 <= to) {
+		const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+		__m256i idx = loadIndices(tour + i);
+		__m256 xa = _mm256_i32gather_ps(x, idx, 4);
+		__m256 ya = _mm256_i32gather_ps(y, idx, 4);
+		for (; i + 16 <= to; i += 8) {
+			idx = loadIndices(tour + i + 8);
+			__m256 xn = _mm256_i32gather_ps(x, idx, 4);
+			__m256 yn = _mm256_i32gather_ps(y, idx, 4);
+			__m256 xb = _mm256_blend_ps(_mm256_permutevar8x32_ps(xa, rotate), _mm256_permutevar8x32_ps(xn, rotate), 0x80);
+			__m256 yb = _mm256_blend_ps(_mm256_permutevar8x32_ps(ya, rotate), _mm256_permutevar8x32_ps(yn, rotate), 0x80);
+			__m256 dx = _mm256_sub_ps(xa, xb);
+			__m256 dy = _mm256_sub_ps(ya, yb);
+			sum = _mm256_add_ps(sum, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy))));
+			xa = xn;
+			ya = yn;
+		}
+	}
+	return horizontalSum(sum) + coordEdgesScalar(x, y, tour, i, to);
+}
+
+// AVX2 kernel on the dense matrix, the 8 entries of the edges are gathered at once
+//
+template <typename TIdx>
+__TARGET_AVX2__ float matrixEdgesAVX2(const float *matrix, int vtxCount, const TIdx *tour, int from, int to) {
+	int i = from;
+	__m256 sum = _mm256_setzero_ps();
+	const __m256i rows = _mm256_set1_epi32(vtxCount);
+	for (; i + 8 <= to; i += 8) {
+		__m256i a = loadIndices(tour + i);
+		__m256i b = loadIndices(tour + i + 1);
+		sum = _mm256_add_ps(sum, _mm256_i32gather_ps(matrix, _mm256_add_epi32(_mm256_mullo_epi32(a, rows), b), 4));
+	}
+	return horizontalSum(sum) + matrixEdgesScalar(matrix, vtxCount, tour, i, to);
+}
+
+#endif
+
+
+
+// function to sum the edges of a tour of vtxCount cities from their coordinates, with the Euclidean distance,
+// the edge closing the tour included, with the kernel of the given level
+//
+template <typename TIdx>
+float coordTourLength(const float *x, const float *y, const TIdx *tour, int vtxCount, GSimdLevel level) {
+	int last = vtxCount - 1;
+	float dx = x[tour[last]] - x[tour[0]];
+	float dy = y[tour[last]] - y[tour[0]];
+	float closing = sqrtf(dx * dx + dy * dy);
+#ifdef __SIMD_X86__
+	if (level == G_SIMD_AVX2)
+		return closing + coordEdgesAVX2(x, y, tour, 0, last);
+	if (level == G_SIMD_SSE)
+		return closing + coordEdgesSSE(x, y, tour, 0, last);
+#else
+	(void)level;
+#endif
+	return closing + coordEdgesScalar(x, y, tour, 0, last);
+}
+
+// function to sum the edges of a tour of vtxCount cities from a dense vtxCount x vtxCount distance matrix,
+// the edge closing the tour included, with the kernel of the given level
+//
+template <typename TIdx>
+float matrixTourLength(const float *matrix, const TIdx *tour, int vtxCount, GSimdLevel level) {
+	int last = vtxCount - 1;
+	float closing = matrix[tour[last] * vtxCount + tour[0]];
+#ifdef __SIMD_X86__
+	if (level == G_SIMD_AVX2)
+		return closing + matrixEdgesAVX2(matrix, vtxCount, tour, 0, last);
+	if (level == G_SIMD_SSE)
+		return closing + matrixEdgesSSE(matrix, vtxCount, tour, 0, last);
+#else
+	(void)level;
+#endif
+	return closing + matrixEdgesScalar(matrix, vtxCount, tour, 0, last);
+}
+
+
+
+#endif /*__TOURLENGTH_H__*/